@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Projections {
+    // Flat listing of every file below a set of root directories, built with one parallel crawl.
+    // Paths are kept normalized with '/' separators and sorted, so everything below
+    // a directory is one contiguous range. The index is read only once built.
+    class FileIndex {
+    public:
+        struct Entry {
+            std::string path{};
+            uint64_t size{};
+            int64_t modified{};
+            uint32_t nameStart{};
+            uint32_t extStart{};
+
+            std::string_view getName() const { return std::string_view(path).substr(nameStart); }
+            // Extension without the '.', empty if there's none.
+            std::string_view getExtension() const { return std::string_view(path).substr(extStart); }
+        };
+
+        // Crawls every root recursively, replacing what was indexed before.
+        // If the running task is canceled the crawl stops and the index is left empty.
+        void build(const std::vector<std::string>& roots);
+        void clear();
+
+        size_t size() const { return _entries.size(); }
+        const std::vector<Entry>& getEntries() const { return _entries; }
+
+        // True if 'dir' is one of the roots or inside of one, only then is its listing complete.
+        bool covers(std::string_view dir) const;
+        // Appends every file below 'dir' to 'files', returns false if 'dir' isn't covered.
+        bool getFiles(std::string_view dir, std::vector<const Entry*>& files) const;
+
+        static std::string normalize(std::string_view path);
+        // Normalized path for comparing paths by value, case folded where the file system ignores case.
+        static std::string makeKey(std::string_view path);
+
+    private:
+        std::vector<std::string> _roots{};
+        std::vector<Entry> _entries{};
+    };
+}
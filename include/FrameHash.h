@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <smmintrin.h>
+
+namespace Projections {
+    // Content fingerprint of a frame.
+    // Four CRC32C lanes run over interleaved 8 byte words, which lets the SSE4.2 'crc32'
+    // instruction keep several independent dependency chains in flight.
+    // Next to every CRC lane runs a 64-bit multiply-xorshift lane over the same words. It isn't
+    // linear like CRC, so different frames rarely share a hash, equal hashes still get compared.
+    // Lanes start at zero with no final xor, so all zero data always hashes to zero.
+    struct alignas(16) FrameHash {
+        static constexpr size_t LANES = 4;
+        static constexpr size_t STRIDE = LANES * sizeof(uint64_t);
+
+        uint32_t lanes[LANES]{ 0 };
+        uint64_t checks[LANES]{ 0 };
+
+        void clear() {
+            memset(lanes, 0, sizeof(lanes));
+            memset(checks, 0, sizeof(checks));
+        }
+
+        // Returns false if the hash is zero, ie. the data was empty or all zeroes.
+        bool from(const uint8_t* data, size_t size);
+
+        // Streams more data into the hash, every call but the last must pass a multiple
+        // of STRIDE bytes for the result to match 'from' over the whole buffer.
+        void update(const uint8_t* data, size_t size);
+
+        // Same as 'update' but always on the portable path it falls back to without SSE4.2.
+        void updateScalar(const uint8_t* data, size_t size);
+
+        bool isZero() const {
+            return (lanes[0] | lanes[1] | lanes[2] | lanes[3]) == 0;
+        }
+
+        uint64_t getKey() const {
+            return (uint64_t(lanes[0]) | (uint64_t(lanes[1]) << 32)) ^
+                  ((uint64_t(lanes[2]) | (uint64_t(lanes[3]) << 32)) * 0x9E3779B97F4A7C15ULL);
+        }
+
+        bool operator==(const FrameHash& other) const {
+            const __m128i* lhs = reinterpret_cast<const __m128i*>(lanes);
+            const __m128i* rhs = reinterpret_cast<const __m128i*>(other.lanes);
+            __m128i eq = _mm_cmpeq_epi32(_mm_load_si128(lhs), _mm_load_si128(rhs));
+            eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_load_si128(lhs + 1), _mm_load_si128(rhs + 1)));
+            eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_load_si128(lhs + 2), _mm_load_si128(rhs + 2)));
+            return _mm_movemask_epi8(eq) == 0xFFFF;
+        }
+
+        bool operator!=(const FrameHash& other) const {
+            return !(*this == other);
+        }
+
+        static bool hasHardwareCRC();
+    };
+}
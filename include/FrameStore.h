@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <J-Core/IO/FileStream.h>
+#include <FrameHash.h>
+
+namespace Projections {
+    // Export wide, content addressed store of frames shared between projections.
+    // Frames are registered per projection in a pre-pass, only frames referenced by
+    // at least two projections are written to the store, everything else stays local.
+    //
+    // File layout:
+    //  'PFRM', version, frame count, table offset (uint64)
+    //  frame blobs...
+    //  table of (offset (uint64), size (uint32)) per frame ID
+    class FrameStore {
+    public:
+        static constexpr char HEADER[] = "PFRM";
+        static constexpr uint32_t VERSION = 1;
+
+        static uint64_t makeKey(const FrameHash& hash, int32_t width, int32_t height) {
+            return hash.getKey() ^ ((uint64_t(uint32_t(width)) << 16 | uint32_t(height)) * 0xC2B2AE3D27D4EB4FULL);
+        }
+
+        ~FrameStore() { close(); }
+
+        void reset();
+
+        void addReference(uint64_t key, uint32_t owner);
+        bool isShared(uint64_t key) const;
+        size_t getSharedCount() const { return _sharedCount; }
+
+        bool open(const std::string& path);
+        // Writes the frame table and moves the store in place, an empty store is discarded.
+        bool close();
+        bool isOpen() const { return _stream.isOpen(); }
+
+        // Returns the ID of the blob, blobs with the same key and bytes are only stored once.
+        uint32_t add(uint64_t key, const uint8_t* data, size_t size);
+
+        size_t getFrameCount() const { return _entries.size(); }
+        size_t getReuseCount() const { return _reused; }
+        uint64_t getDataSize() const { return _dataSize; }
+
+    private:
+        static constexpr uint32_t SHARED_OWNER = UINT32_MAX;
+
+        struct Entry {
+            uint64_t offset{};
+            uint32_t size{};
+        };
+
+        JCore::FileStream _stream{};
+        std::string _path{};
+        std::string _pathTmp{};
+
+        std::unordered_map<uint64_t, uint32_t> _owners{};
+        size_t _sharedCount{};
+
+        std::vector<Entry> _entries{};
+        std::unordered_multimap<uint64_t, uint32_t> _index{};
+        std::vector<uint8_t> _compareBuffer{};
+        size_t _reused{};
+        uint64_t _dataSize{};
+    };
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace Projections {
+    // Read only memory mapping of a whole file.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() { close(); }
+
+        // 'sequential' hints the OS to read ahead and drop pages behind us.
+        bool open(const std::string& path, bool sequential = true);
+        void close();
+
+        bool isOpen() const { return _data != nullptr; }
+        const uint8_t* data() const { return _data; }
+        size_t size() const { return _size; }
+
+    private:
+        const uint8_t* _data{};
+        size_t _size{};
+#ifdef _WIN32
+        void* _file{};
+        void* _mapping{};
+#endif
+    };
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <J-Core/IO/ImageUtils.h>
+#include <J-Core/Util/DataFormatUtils.h>
+
+namespace Projections {
+    // Decodes 8-bit RGB(A) PNG, uncompressed BMP and DDS sources straight from a memory mapping
+    // into RGBA32, without reading the file into an intermediate heap buffer first.
+    // Returns false for other formats or layouts, callers then fall back to J-Core's decoders.
+    // JTEX always goes through J-Core, its layout is private to J-Core and may change with it.
+    bool decodeMapped(const std::string& path, JCore::DataFormat format, JCore::ImageData& img);
+
+    // Image format from the file extension, FMT_UNKNOWN for anything we can't read.
+    JCore::DataFormat getImageFormat(std::string_view path);
+    // Full decode, mapped if possible and through J-Core otherwise.
+    bool decodeImageFile(const std::string& path, JCore::DataFormat format, JCore::ImageData& img);
+    // Decodes a file that's already in memory with the built-in decoders only, J-Core's decoders
+    // only read from paths. Fails for every format and layout 'decodeMapped' doesn't handle.
+    bool decodeImageMemory(const uint8_t* data, size_t size, JCore::DataFormat format, JCore::ImageData& img);
+    // Enough of the start of a file for 'getImageMemoryInfo', the DDS header is the largest.
+    static constexpr size_t IMAGE_HEADER_SIZE = 128;
+    // Reads the header of a file that's in memory, 'data' only needs its first IMAGE_HEADER_SIZE bytes.
+    // Fails for anything 'decodeImageMemory' would fail on from the header alone.
+    bool getImageMemoryInfo(const uint8_t* data, size_t size, JCore::DataFormat format, JCore::ImageData& img);
+    // Reads just the header.
+    bool getImageFileInfo(const std::string& path, JCore::DataFormat format, JCore::ImageData& img);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <smmintrin.h>
+#include <J-Core/Math/Color32.h>
+
+namespace Projections {
+    enum DitherMode : uint8_t {
+        DITHER_None = 0x00,
+        DITHER_Ordered,
+        DITHER_FloydSteinberg,
+
+        DITHER_COUNT
+    };
+
+    struct ColorHistogram {
+        std::unordered_map<uint32_t, uint64_t> counts{};
+
+        void clear() {
+            counts.clear();
+        }
+
+        size_t size() const { return counts.size(); }
+
+        void add(const JCore::Color32* pixels, size_t count);
+        void merge(const ColorHistogram& other);
+    };
+
+    struct QuantizeStats {
+        double sqError{};
+        uint64_t samples{};
+
+        void reset() {
+            sqError = 0;
+            samples = 0;
+        }
+
+        double getPSNR() const;
+    };
+
+    class PaletteQuantizer {
+    public:
+        static constexpr int32_t MAX_COLORS = 256;
+
+        void clear();
+
+        // Builds a palette of at most 'maxColors' colors with median cut followed by
+        // a few k-means passes, all in Oklab with alpha as a fourth axis.
+        // Fully transparent pixels always keep an exact entry of their own.
+        bool build(const ColorHistogram& histogram, int32_t maxColors);
+
+        // PSNR of mapping the histogram without dithering.
+        double estimatePSNR(const ColorHistogram& histogram) const;
+
+        void apply(JCore::Color32* pixels, int32_t width, int32_t height, DitherMode dither, QuantizeStats* stats = nullptr);
+
+        // Index of the palette color closest to 'color' in Oklab + alpha.
+        int32_t findNearest(JCore::Color32 color) const;
+        int32_t getColorCount() const { return int32_t(_colors.size()); }
+        const JCore::Color32* getColors() const { return _colors.data(); }
+
+    private:
+        static constexpr int32_t CACHE_SIZE = 4096;
+
+        struct CacheEntry {
+            uint32_t color;
+            int32_t index;
+        };
+
+        std::vector<JCore::Color32> _colors{};
+        __m128i _simdColors[MAX_COLORS >> 1]{};
+        int32_t _simdCount{};
+        CacheEntry _cache[CACHE_SIZE]{};
+
+        void refreshLookup();
+        int32_t findNearestCached(JCore::Color32 color);
+    };
+}
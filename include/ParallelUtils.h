@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Projections {
+    inline size_t getWorkerCount(size_t maxWorkers = 0) {
+        size_t count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return maxWorkers > 0 ? std::min(count, maxWorkers) : count;
+    }
+
+    // Set on threads running a parallelFor, nested loops then stay on their thread
+    // instead of multiplying the thread count.
+    inline bool& isParallelWorker() {
+        thread_local bool isWorker = false;
+        return isWorker;
+    }
+
+    // Runs 'func(index, worker)' for every index in [0, count) on up to 'workers' threads.
+    // Indices are handed out in order from a shared counter, 'worker' is in [0, workers)
+    // and can be used to pick per thread scratch data. The calling thread acts as worker 0.
+    // Called from inside another parallelFor, the loop runs serially as worker 0.
+    template<typename Func>
+    inline void parallelFor(size_t count, size_t workers, Func&& func) {
+        workers = std::min(std::max<size_t>(workers, 1), count);
+        if (workers <= 1 || isParallelWorker()) {
+            for (size_t i = 0; i < count; i++) {
+                func(i, size_t(0));
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{ 0 };
+        auto run = [&next, &func, count](size_t worker) {
+            bool& isWorker = isParallelWorker();
+            bool wasWorker = isWorker;
+            isWorker = true;
+
+            size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+                func(i, worker);
+            }
+            isWorker = wasWorker;
+        };
+
+        std::vector<std::thread> threads{};
+        threads.reserve(workers - 1);
+        for (size_t i = 1; i < workers; i++) {
+            threads.emplace_back(run, i);
+        }
+        run(0);
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+}
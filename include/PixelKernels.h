@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <J-Core/Math/Color32.h>
+
+namespace Projections {
+    enum UI8Mode : uint8_t {
+        UI8_Red = 0x01,
+        UI8_Green = 0x02,
+        UI8_Blue = 0x04,
+        UI8_Alpha = 0x08,
+    };
+
+    // Bulk pixel conversion kernels, the source format is resolved once per image
+    // instead of per pixel. The Color32 kernels zero out pixels with alpha below 'alphaClip'.
+    namespace Kernels {
+        // 'src' and 'dst' may be the same buffer.
+        void clipRGBA32(const JCore::Color32* src, JCore::Color32* dst, size_t count, uint8_t alphaClip);
+        void expandRGB24(const uint8_t* src, JCore::Color32* dst, size_t count);
+        void expandBGR24(const uint8_t* src, JCore::Color32* dst, size_t count);
+        // 'opaque' forces alpha to 255 for sources whose fourth channel is unused.
+        void swizzleBGRA32(const uint8_t* src, JCore::Color32* dst, size_t count, bool opaque);
+        void expandIndexed8(const uint8_t* src, const JCore::Color32* lut, JCore::Color32* dst, size_t count, uint8_t alphaClip);
+
+        // 'a * b / 255' rounded to nearest, what the SIMD kernels use to apply alpha.
+        // A product over 255 never lands on a half, so this is exact for every pair of bytes,
+        // the same result as JCore::multUI8 without its division.
+        inline uint8_t mulDiv255(uint32_t a, uint32_t b) {
+            uint32_t t = a * b + 128;
+            return uint8_t((t + (t >> 8)) >> 8);
+        }
+
+        // Premultiplies RGB by alpha in place with 'mulDiv255' rounding, alpha is kept as is.
+        // Every premultiplied frame and palette goes through this, so they all share one rounding.
+        void premultiplyRGBA32(JCore::Color32* data, size_t count);
+
+        // True if every pixel is zero, ie. fully transparent after clipping.
+        bool isZero(const JCore::Color32* data, size_t count);
+
+        // Smallest and largest index in 'src', 'count' must be at least 1.
+        void rangeUI16(const uint16_t* src, size_t count, uint16_t& lowest, uint16_t& highest);
+        // 'dst[i] = src[i] - offset', every result must fit in 8 bits.
+        void narrowUI16(const uint16_t* src, uint8_t* dst, size_t count, uint16_t offset);
+        void widenUI8(const uint8_t* src, uint16_t* dst, size_t count);
+
+        // Reduces RGBA32 pixels to one byte per pixel as selected by 'colorMask' (UI8Mode bits),
+        // RGB uses 16.16 fixed-point Rec. 601 luma.
+        void reduceToUI8(const JCore::Color32* src, uint8_t* dst, size_t count, uint8_t colorMask);
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <J-Core/IO/ImageUtils.h>
+
+namespace Projections {
+    // PNG decoder specialized for what frame sources almost always are: non-interlaced,
+    // 8-bit RGB or RGBA. Inflates and unfilters straight into an RGBA32 image.
+    namespace PngDecoder {
+        // Returns false for any other kind of PNG and for malformed or truncated data,
+        // every read and write is bounds checked so any input is safe to pass in.
+        bool decode(const uint8_t* data, size_t size, JCore::ImageData& img);
+
+        // Signature and IHDR, all 'getInfo' needs to see.
+        static constexpr size_t HEADER_SIZE = 8 + 25;
+        // Size and format from the header alone, fails for the same kinds of PNG 'decode' does.
+        bool getInfo(const uint8_t* data, size_t size, JCore::ImageData& img);
+    }
+}
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <vector>
+#include <unordered_map>
 #include <limits>
 #include <functional>
 #include <glm.hpp>
@@ -24,9 +25,19 @@
 
 #include <smmintrin.h>
 #include <J-Core/Util/AlignmentAllocator.h>
+#include <PaletteQuantizer.h>
+#include <FrameHash.h>
+#include <FrameStore.h>
+#include <MappedImage.h>
+#include <SpriteSheet.h>
+#include <ZipArchive.h>
+#include <RawStream.h>
+#include <FileIndex.h>
+#include <memory>
+#include <filesystem>
 
 namespace Projections {
-    static constexpr int32_t PROJ_GEN_VERSION = 2;
+    static constexpr int32_t PROJ_GEN_VERSION = 3;
 
     namespace detail {
         static inline void maskSimdIndices(const __m128i& simd, __m128i& buffer) {
@@ -69,51 +80,6 @@ namespace Projections {
         }
     }
 
-    struct alignas(16) CRCBlocks {
-        uint32_t crcs[8]{ 0 };
-
-        void clear() {
-            memset(crcs, 0, sizeof(crcs));
-        }
-
-        bool from(const uint8_t* data, size_t size) {
-            using namespace JCore;
-            clear();
-            if (size < 0 || !data) { return false; }
-            size_t chunkSize = Math::max(size >> 3, 1ULL);
-
-            size_t left = size;
-            size_t ind = 0;
-            uint32_t crcV = 0x00;
-            while (left > 0 && ind < 8) {
-                size_t len = Math::min(left, chunkSize);
-                crcV |= (crcs[ind++] = JCore::Data::calcuateCRC(data, len));
-                data += len;
-                left -= len;
-            }
-            return crcV != 0x00;
-        }
-
-        const bool operator==(const CRCBlocks& other) const {
-            const __m128i* lhs = reinterpret_cast<const __m128i*>(crcs);
-            const __m128i* rhs = reinterpret_cast<const __m128i*>(other.crcs);
-            return (
-                detail::getSimdMask(_mm_cmpeq_epi32(lhs[0], rhs[0])) &
-                detail::getSimdMask(_mm_cmpeq_epi32(lhs[1], rhs[1]))
-                ) == 0xFFFFFFFFU;
-
-        }
-
-        const bool operator!=(const CRCBlocks& other) const {
-            const __m128i* lhs = reinterpret_cast<const __m128i*>(crcs);
-            const __m128i* rhs = reinterpret_cast<const __m128i*>(other.crcs);
-            return (
-                detail::getSimdMask(_mm_cmpeq_epi32(lhs[0], rhs[0])) &
-                detail::getSimdMask(_mm_cmpeq_epi32(lhs[1], rhs[1]))
-                ) != 0xFFFFFFFFU;
-
-        }
-    };
 
     enum TexMode : uint8_t {
         TEX_None = 0x00,
@@ -125,6 +91,16 @@ namespace Projections {
         __TEX_COUNT
     };
 
+    enum PImageMode : uint8_t {
+        PIMG_RGBA32 = 0x00,
+        PIMG_Indexed8,
+        PIMG_Indexed16,
+        // 8-bit indices into a per-frame table of up to 256 global palette indices.
+        PIMG_Local8,
+        // Frame lives in the export's shared frame store, followed by its uint32 ID.
+        PIMG_Shared,
+    };
+
     enum PoolType : uint8_t {
         Pool_None,
         Pool_Trader,
@@ -1088,144 +1064,296 @@ namespace Projections {
 
     struct alignas(16) Palette {
         static constexpr int32_t SIZE = UINT16_MAX + 1;
-        static constexpr int32_t HISTORY_SIZE = 16;
-        static constexpr int32_t HISTORY_SIZE_BIG = 128;
+        static constexpr int32_t CACHE_SIZE = 256;
+        static constexpr uint32_t CACHE_MASK = CACHE_SIZE - 1;
+        static constexpr int32_t TABLE_SIZE = SIZE << 1;
+        static constexpr uint32_t TABLE_MASK = TABLE_SIZE - 1;
+        static constexpr int32_t FIXED_SIZE = SIZE << 2;
+        static constexpr uint32_t FIXED_MASK = FIXED_SIZE - 1;
+
+        struct CacheEntry {
+            uint32_t color;
+            int32_t index;
+        };
 
         JCore::Color32 colors[SIZE]{};
         int32_t count{};
+        int32_t committed{};
+
+        uint32_t lastColor{ 0 };
+        int32_t lastIndex{ -1 };
+        CacheEntry cache[CACHE_SIZE]{};
+
+        // Open addressed color -> (index + 1) table, 0 marks an empty slot.
+        int32_t table[TABLE_SIZE]{};
+
+        // Two choice table of a palette fixed with setColors. Every color sits in one of
+        // its two slots, so lookup never probes. Empty slots hold 0 and only match colors[0].
+        uint16_t fixed[FIXED_SIZE]{};
+        uint32_t fixedSeed{};
 
-        int32_t histSize;
-        uint32_t historyC{ 0 };
-        int32_t history[HISTORY_SIZE_BIG]{};
+        uint64_t cacheHits{ 0 };
+        uint64_t cacheMisses{ 0 };
 
         void clear() {
             count = 0;
-            historyC = 0;
-            histSize = HISTORY_SIZE - 1;
+            committed = 0;
+            cacheHits = 0;
+            cacheMisses = 0;
             memset(colors, 0, sizeof(colors));
-            memset(&history, 0xFF, sizeof(history));
+            memset(table, 0, sizeof(table));
+            memset(fixed, 0, sizeof(fixed));
+            clearCache();
         }
 
-        template<typename T>
-        static __forceinline void swap(T& lhs, T& rhs) {
-            T tmp = rhs;
-            rhs = lhs;
-            lhs = rhs;
+        void clearCache() {
+            lastColor = 0;
+            lastIndex = -1;
+            for (auto& entry : cache) {
+                entry.color = 0;
+                entry.index = -1;
+            }
         }
 
-        int32_t indexOf(JCore::Color32 color) const {
-            using namespace JCore;
-            if (count > (SIZE >> 2)) {
-                static constexpr int32_t OFFFSET_LUT[64]{
-                    0 , 0 , 0 , 0 ,
-                    1 , 1 , 1 , 1 ,
-                    2 , 2 , 2 , 2 ,
-                    3 , 3 , 3 , 3 ,
-                    4 , 4 , 4 , 4 ,
-                    5 , 5 , 5 , 5 ,
-                    6 , 6 , 6 , 6 ,
-                    7 , 7 , 7 , 7 ,
-                    8 , 8 , 8 , 8 ,
-                    9 , 9 , 9 , 9 ,
-                    10, 10, 10, 10,
-                    11, 11, 11, 11,
-                    12, 12, 12, 12,
-                    13, 13, 13, 13,
-                    14, 14, 14, 14,
-                    15, 15, 15, 15,
-                };
-
-                __m128i key = _mm_set1_epi32(reinterpret_cast<int32_t&>(color));
-                const __m128i* simdPtr = reinterpret_cast<const __m128i*>(colors);
-
-                int32_t sCount = count >> 5;
-                uint64_t mask = 0;
-                for (int32_t i = 0, j = 0; i < sCount; i++, j += 32) {
-                    mask = uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key)));
-                    mask |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key))) << 16;
-                    mask |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key))) << 32;
-                    mask |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key))) << 48;
-
-                    if (mask != 0) {
-                        return i + OFFFSET_LUT[Math::findFirstLSB(mask)];
-                    }
+        // Replaces the palette with a fixed set of colors, used when the palette has been planned ahead.
+        // Returns false if the colors couldn't be placed for lookup, which then must not be used.
+        bool setColors(const uint32_t* values, int32_t length) {
+            clear();
+            length = length > SIZE ? SIZE : length;
+            for (int32_t i = 0; i < length; i++) {
+                colors[i] = reinterpret_cast<const JCore::Color32&>(values[i]);
+                insert(values[i], i);
+            }
+            count = length;
+            commit();
+            return buildFixed();
+        }
 
-                    mask = uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key)));
-                    mask |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key))) << 16;
-                    mask |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key))) << 32;
-                    mask |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi32(*simdPtr++, key))) << 48;
+        // Colors are only ever appended, so everything past 'committed' is the
+        // pending set of the current frame and doubles as its undo log.
+        void commit() {
+            committed = count;
+        }
 
-                    if (mask != 0) {
-                        return (i + 16) + OFFFSET_LUT[Math::findFirstLSB(mask)];
-                    }
+        void rollback() {
+            if (count <= committed) { return; }
+
+            // Removing in reverse insertion order keeps every remaining probe chain intact.
+            for (int32_t i = count - 1; i >= committed; i--) {
+                uint32_t slot = hashSlot(reinterpret_cast<const uint32_t&>(colors[i]));
+                while (table[slot] != i + 1) {
+                    slot = (slot + 1) & TABLE_MASK;
                 }
+                table[slot] = 0;
+            }
 
-                sCount <<= 4;
-                for (int32_t i = sCount; i < count; i++) {
-                    if (colors[i] == color) {
-                        return i;
-                    }
+            memset(colors + committed, 0, size_t(count - committed) * sizeof(JCore::Color32));
+            for (auto& entry : cache) {
+                if (entry.index >= committed) {
+                    entry.index = -1;
                 }
-                return -1;
             }
 
-            for (int32_t i = 0; i < count; i++) {
-                if (colors[i] == color) {
-                    return i;
+            if (lastIndex >= committed) {
+                lastIndex = -1;
+            }
+            count = committed;
+        }
+
+        float getCacheHitRate() const {
+            uint64_t total = cacheHits + cacheMisses;
+            return total > 0 ? float(double(cacheHits) / double(total)) : 0.0f;
+        }
+
+        static constexpr uint32_t hashColor(uint32_t color) {
+            return ((color * 0x9E3779B1U) >> 24) & CACHE_MASK;
+        }
+
+        static constexpr uint32_t hashSlot(uint32_t color) {
+            return ((color * 0x9E3779B1U) >> 15) & TABLE_MASK;
+        }
+
+        uint32_t fixedSlotA(uint32_t color) const {
+            return ((color * 0x9E3779B1U) >> 14) & FIXED_MASK;
+        }
+
+        uint32_t fixedSlotB(uint32_t color) const {
+            return (((color ^ fixedSeed) * 0x85EBCA77U) >> 14) & FIXED_MASK;
+        }
+
+        // Branch free lookup in a palette fixed with setColors, -1 if 'color' isn't in it.
+        int32_t lookup(JCore::Color32 color) const {
+            const uint32_t key = reinterpret_cast<const uint32_t&>(color);
+            const uint32_t* values = reinterpret_cast<const uint32_t*>(colors);
+            int32_t a = fixed[fixedSlotA(key)];
+            int32_t b = fixed[fixedSlotB(key)];
+            uint32_t colorA = values[a];
+            uint32_t colorB = values[b];
+
+            int32_t isA = -int32_t(colorA == key);
+            int32_t isB = -int32_t(colorB == key);
+            return (a & isA) | (b & ~isA & isB) | ~(isA | isB);
+        }
+
+        int32_t indexOf(JCore::Color32 color) const {
+            const uint32_t key = reinterpret_cast<const uint32_t&>(color);
+            uint32_t slot = hashSlot(key);
+            while (table[slot] != 0) {
+                int32_t index = table[slot] - 1;
+                if (reinterpret_cast<const uint32_t&>(colors[index]) == key) {
+                    return index;
                 }
+                slot = (slot + 1) & TABLE_MASK;
             }
             return -1;
         }
 
         int32_t add(JCore::Color32 color) {
             using namespace JCore;
-            int32_t index;
-            for (int32_t i = 0; i <= histSize; i++) {
-                if (colors[history[i]] == color) {
-                    index = history[i];
-                    if (i) {
-                        swap(history[i], history[i - 1]);
-                    }
-                    return index;
-                }
+            const uint32_t key = reinterpret_cast<const uint32_t&>(color);
+
+            // Frames are mostly long runs of a handful of colors, so check the
+            // previous hit before the direct mapped cache and only then look up.
+            if (lastIndex > -1 && lastColor == key) {
+                cacheHits++;
+                return lastIndex;
+            }
+
+            CacheEntry& entry = cache[hashColor(key)];
+            if (entry.index > -1 && entry.color == key) {
+                cacheHits++;
+                lastColor = key;
+                lastIndex = entry.index;
+                return entry.index;
             }
+            cacheMisses++;
 
-            index = indexOf(color);
+            int32_t index = indexOf(color);
             if (index < 0 && count < SIZE) {
                 index = count++;
                 colors[index] = color;
-                histSize = (count > 1024 ? HISTORY_SIZE_BIG - 1 : HISTORY_SIZE - 1);
+                insert(key, index);
             }
 
             if (index > -1) {
-                history[historyC++ & histSize] = index;
+                entry.color = key;
+                entry.index = index;
+                lastColor = key;
+                lastIndex = index;
             }
             return index;
         }
+
+    private:
+        void insert(uint32_t key, int32_t index) {
+            uint32_t slot = hashSlot(key);
+            while (table[slot] != 0) {
+                slot = (slot + 1) & TABLE_MASK;
+            }
+            table[slot] = index + 1;
+        }
+
+        // Cuckoo inserts every color, the table is at most a quarter full so
+        // a placement rarely fails and another seed is tried if it does.
+        bool buildFixed() {
+            static constexpr int32_t MAX_KICKS = 512;
+            const uint32_t* values = reinterpret_cast<const uint32_t*>(colors);
+            std::vector<bool> used(FIXED_SIZE);
+
+            for (uint32_t attempt = 0; attempt < 8; attempt++) {
+                fixedSeed = 0x27D4EB2FU * attempt;
+                memset(fixed, 0, sizeof(fixed));
+                used.assign(FIXED_SIZE, false);
+
+                bool placed = true;
+                for (int32_t i = 0; i < count && placed; i++) {
+                    uint16_t ind = uint16_t(i);
+                    uint32_t slot = fixedSlotA(values[ind]);
+                    if (used[slot]) {
+                        slot = fixedSlotB(values[ind]);
+                    }
+
+                    placed = false;
+                    for (int32_t kick = 0; kick < MAX_KICKS; kick++) {
+                        if (!used[slot]) {
+                            used[slot] = true;
+                            fixed[slot] = ind;
+                            placed = true;
+                            break;
+                        }
+
+                        // Evict the occupant to its other slot.
+                        std::swap(ind, fixed[slot]);
+                        uint32_t other = fixedSlotA(values[ind]);
+                        slot = other == slot ? fixedSlotB(values[ind]) : other;
+                    }
+                }
+
+                if (placed) { return true; }
+            }
+            memset(fixed, 0, sizeof(fixed));
+            return false;
+        }
+    };
+
+    struct PExportSettings {
+        bool planPalettes{ false };
+        bool sharedFrames{ false };
+        // Checks every fused frame pass against the multi-pass reference.
+        bool verifyFused{ false };
+    };
+
+    struct FramePlan {
+        uint8_t imageMode{ PIMG_RGBA32 };
+        uint16_t pOffset{};
     };
 
     struct PBuffers {
         JCore::ImageData readBuffer{};
         JCore::ImageData frameBuffer{};
+        JCore::ImageData compareBuffer{};
         JCore::AudioData audioBuffer{};
 
         uint8_t* idxUI8{};
         uint16_t* idxUI16{};
 
         bool noPalette{ false };
-        Palette palettePrev{};
         Palette palette{};
 
+        bool useQuantizer{ false };
+        DitherMode dither{};
+        PaletteQuantizer quantizer{};
+        QuantizeStats quantizeStats{};
+
+        PExportSettings settings{};
+        bool usePlan{ false };
+        std::vector<FramePlan> framePlans{};
+
+        uint16_t localTable[256]{};
+        std::vector<int16_t> localMap{};
+
+        // Frame content key -> (frame index * 2 + emission) of every slot written with data.
+        std::unordered_multimap<uint64_t, uint32_t> frameIndex{};
+        // Pointer value a later slot aliasing each slot should write, 0 for empty slots.
+        std::vector<uint32_t> slotPointers{};
+        uint64_t hashedBytes{};
+        double hashSeconds{};
+        uint32_t emptyFrames{};
+
+        // Set while exporting with a shared frame store.
+        FrameStore* store{};
+        std::vector<uint8_t> sharedBlob{};
+
         void init(int32_t maxResolution, int32_t baseSamples) {
             using namespace JCore;
+            // The frame buffer is only needed for non RGBA32 or quantized frames, it's allocated on first use.
             readBuffer.doAllocate(maxResolution, maxResolution, TextureFormat::RGBA32);
-            frameBuffer.doAllocate(maxResolution, maxResolution, TextureFormat::RGBA32);
             audioBuffer.doAllocate(AudioFormat::PCM, AudioSampleType::Signed, 16, 2, baseSamples);
 
             if (idxUI8 != nullptr) { free(idxUI8); }
             idxUI8 = reinterpret_cast<uint8_t*>(malloc(size_t(maxResolution) * maxResolution * 3));
             idxUI16 = reinterpret_cast<uint16_t*>(idxUI8 + maxResolution * maxResolution);
-            palettePrev.clear();
+            localMap.assign(Palette::SIZE, -1);
             palette.clear();
             noPalette = false;
         }
@@ -1233,7 +1361,6 @@ namespace Projections {
         void clear() {
             using namespace JCore;
             char temp[256]{ 0 };
-            palettePrev.clear();
             palette.clear();
 
             Utils::formatDataSize(temp, readBuffer.getBufferSize());
@@ -1244,11 +1371,19 @@ namespace Projections {
             JCORE_INFO("Freeing Frame Buffer %s", temp);
             frameBuffer.clear(true);
 
+            compareBuffer.clear(true);
+            frameIndex.clear();
+            slotPointers.clear();
+            sharedBlob.clear();
+            sharedBlob.shrink_to_fit();
+
             Utils::formatDataSize(temp, audioBuffer.getBufferSize());
             JCORE_INFO("Freeing Audio Buffer %s", temp);
             audioBuffer.clear(true);
 
             noPalette = false;
+            usePlan = false;
+            framePlans.clear();
             if (idxUI8) {
                 free(idxUI8);
                 idxUI8 = nullptr;
@@ -1872,7 +2007,7 @@ namespace Projections {
 
         constexpr PFrameIndex() : data() {}
         constexpr PFrameIndex(int32_t frame, int32_t layer, bool isEmissive) :
-            data((frame & 0x7FFFFFU) | ((frame & 0x7FU) << 23) | (isEmissive ? 0x80000000U : 0x00))
+            data((frame & 0x7FFFFFU) | ((layer & 0x7FU) << 23) | (isEmissive ? 0x80000000U : 0x00))
         {}
 
         constexpr PFrameIndex(uint32_t data) :
@@ -1963,60 +2098,109 @@ namespace Projections {
     static constexpr PFrameIndex NullIdx = PFrameIndex(0xFFFFFFFFU);
 
     struct PFramePath {
+        static constexpr uint32_t NO_ALIAS = UINT32_MAX;
+
         std::string path{};
         PFrameIndex index{};
         JCore::DataFormat format{};
+        // Slot (frame index * 2 + emission) of an earlier source with byte identical file contents.
+        uint32_t aliasOf{ NO_ALIAS };
+        // Set for frames sliced out of a sprite sheet, 'path' is then only a label.
+        std::shared_ptr<SheetSource> sheet{};
+        SheetRect rect{};
+        // Set for frames read from a ZIP framePath, 'path' is then the entry name.
+        std::shared_ptr<ZipArchive> archive{};
+        // Set for frames of a raw stream, 'path' is then only a label.
+        std::shared_ptr<StreamSource> stream{};
+        // Entry in 'archive' or frame in 'stream'.
+        size_t entry{};
+        // Size of the file if it was listed by a FileIndex, saves a stat later on.
+        uint64_t fileSize{};
+        // Read from the source's header during prepare, decoded frames have to match it.
+        int32_t width{};
+        int32_t height{};
 
         PFramePath() : path(""), index(), format() {}
-        PFramePath(std::string_view str, PFrameIndex idx) : path(str), index(idx), format() {
-            using namespace JCore;
-            if (Utils::endsWith(str, ".png", false)) {
-                format = FMT_PNG;
-            }
-            else if (Utils::endsWith(str, ".bmp", false)) {
-                format = FMT_BMP;
-            }
-            else if (Utils::endsWith(str, ".dds", false)) {
-                format = FMT_DDS;
+        PFramePath(std::string_view str, PFrameIndex idx) : path(str), index(idx), format(getImageFormat(str)) {}
+        PFramePath(const std::shared_ptr<SheetSource>& sheet, const SheetRect& rect, size_t cell, PFrameIndex idx) :
+            path(sheet->getPath() + "#" + std::to_string(cell)), index(idx), format(JCore::FMT_UNKNOWN), sheet(sheet), rect(rect) {}
+        PFramePath(const std::shared_ptr<ZipArchive>& archive, size_t entry, PFrameIndex idx) :
+            path(archive->getEntry(entry).name), index(idx), format(getImageFormat(path)), archive(archive), entry(entry) {}
+        PFramePath(const std::shared_ptr<StreamSource>& stream, size_t frame, PFrameIndex idx) :
+            path(stream->getPath() + "#" + std::to_string(frame)), index(idx), format(JCore::FMT_UNKNOWN), stream(stream), entry(frame) {}
+
+        bool getInfo(JCore::ImageData& img, std::string_view root) const {
+            if (sheet) {
+                img.width = rect.width;
+                img.height = rect.height;
+                img.format = JCore::TextureFormat::RGBA32;
+                return true;
             }
-            else if (Utils::endsWith(str, ".jtex", false)) {
-                format = FMT_JTEX;
+
+            if (stream) {
+                img.width = stream->getWidth();
+                img.height = stream->getHeight();
+                img.format = JCore::TextureFormat::RGBA32;
+                return true;
             }
-            else {
-                format = FMT_UNKNOWN;
+
+            if (archive) {
+                // Only as much of the entry is extracted as its header takes.
+                thread_local std::vector<uint8_t> header{};
+                return archive->readPrefix(entry, IMAGE_HEADER_SIZE, header) && getImageMemoryInfo(header.data(), header.size(), format, img);
             }
+            return getImageFileInfo(JCore::IO::combine(root, this->path), format, img);
         }
+        bool decodeImage(JCore::ImageData& img, std::string_view root) const {
+            if (sheet) {
+                return sheet->slice(rect, root, img);
+            }
 
-        bool getInfo(JCore::ImageData& img, std::string_view root) const {
-            using namespace JCore;
+            if (stream) {
+                return stream->readFrame(entry, img);
+            }
 
-            std::string path = IO::combine(root, this->path);
-            switch (format)
-            {
-            case JCore::FMT_PNG:  return Png::getInfo(path.c_str(), img);
-            case JCore::FMT_BMP:  return Bmp::getInfo(path.c_str(), img);
-            case JCore::FMT_DDS:  return DDS::getInfo(path.c_str(), img);
-            case JCore::FMT_JTEX: return JTEX::getInfo(path.c_str(), img);
-            default: return false;
+            if (archive) {
+                thread_local std::vector<uint8_t> bytes{};
+                return archive->read(entry, bytes) && decodeImageMemory(bytes.data(), bytes.size(), format, img);
             }
+            return decodeImageFile(JCore::IO::combine(root, this->path), format, img);
         }
-        bool decodeImage(JCore::ImageData& img, std::string_view root) const {
-            using namespace JCore;
 
-            std::string path = IO::combine(root, this->path);
-            switch (format)
-            {
-            case JCore::FMT_PNG:  return Png::decode(path.c_str(), img);
-            case JCore::FMT_BMP:  return Bmp::decode(path.c_str(), img);
-            case JCore::FMT_DDS:  return DDS::decode(path.c_str(), img);
-            case JCore::FMT_JTEX: return JTEX::decode(path.c_str(), img);
-            default: return false;
+        // Size and raw bytes of the source file, used to find byte identical sources.
+        uint64_t getFileSize(std::string_view root) const {
+            if (archive) {
+                return archive->getEntry(entry).size;
+            }
+            if (fileSize > 0) {
+                return fileSize;
             }
+
+            std::error_code err{};
+            uint64_t size = uint64_t(std::filesystem::file_size(JCore::IO::combine(root, path), err));
+            return err ? 0 : size;
         }
+        bool readFileBytes(std::string_view root, std::vector<uint8_t>& data) const;
 
         bool isValid() const {
             return index != NullIdx && path.length() > 0;
         }
+
+        bool isAlias() const {
+            return aliasOf != NO_ALIAS;
+        }
+
+        bool isSliced() const {
+            return sheet != nullptr;
+        }
+
+        bool isStreamed() const {
+            return stream != nullptr;
+        }
+
+        bool isArchived() const {
+            return archive != nullptr;
+        }
     };
 
     static inline bool compare(const PFramePath& lhs, const PFramePath& rhs) {
@@ -2051,7 +2235,7 @@ namespace Projections {
 
         PFramePath path{};
         PFramePath pathE{};
-        CRCBlocks block[2]{};
+        FrameHash hash[2]{};
 
         void reset() {
             frameDuration = 0.0f;
@@ -2059,8 +2243,8 @@ namespace Projections {
             path = PFramePath("", NullIdx);
             pathE = PFramePath("", NullIdx);
 
-            block[0].clear();
-            block[1].clear();
+            hash[0].clear();
+            hash[1].clear();
         }
     };
 
@@ -2454,6 +2638,67 @@ namespace Projections {
         void write(const Stream& stream, std::string_view root, int32_t width, int32_t height) const;
     };
 
+    struct QuantizeInfo {
+        bool enabled{};
+        int32_t colors{};
+        DitherMode dither{};
+        float minPSNR{};
+
+        void reset() {
+            enabled = false;
+            colors = 256;
+            dither = DitherMode::DITHER_None;
+            minPSNR = 30.0f;
+        }
+
+        void read(const json& jsonF) {
+            using namespace JCore;
+            reset();
+            if (jsonF.is_object()) {
+                enabled = jsonF.value("enabled", false);
+                colors = Math::clamp(jsonF.value("colors", 256), 2, PaletteQuantizer::MAX_COLORS);
+                dither = jsonF.value("dither", DitherMode::DITHER_None);
+                minPSNR = Math::max(jsonF.value("minPSNR", 30.0f), 0.0f);
+            }
+        }
+
+        void write(json& jsonF) const {
+            jsonF["enabled"] = enabled;
+            jsonF["colors"] = colors;
+            jsonF["dither"] = dither;
+            jsonF["minPSNR"] = minPSNR;
+        }
+    };
+
+    // What an export learns about a projection's frames in its single analysis pass,
+    // shared by the frame store, the quantizer and palette planning.
+    struct FrameAnalysis {
+        static constexpr uint32_t MAX_SLOT_COLORS = 256;
+
+        struct Slot {
+            // FrameStore key of the slot's clipped pixels, 0 if keys weren't collected or the slot is empty.
+            uint64_t key{};
+            // Unique colors of the slot, 0 if it wasn't decoded.
+            uint32_t uniqueCount{};
+            // (color, pixel count) of every color, only kept for slots with up to MAX_SLOT_COLORS colors.
+            std::vector<std::pair<uint32_t, uint64_t>> colors{};
+        };
+
+        bool isValid{ false };
+        bool hasColors{ false };
+        std::vector<Slot> slots{};
+        // Clipped colors of every decoded slot.
+        ColorHistogram histogram{};
+
+        void clear() {
+            isValid = false;
+            hasColors = false;
+            slots.clear();
+            slots.shrink_to_fit();
+            histogram.clear();
+        }
+    };
+
     struct Projection {
         PMaterial material{};
 
@@ -2468,6 +2713,8 @@ namespace Projections {
 
         std::vector<PrLayer> layers{};
         std::vector<PrFrame> frames{};
+        std::vector<SpriteSheet> sheets{};
+        std::vector<RawStream> streams{};
 
         std::vector<FrameInfo> frameInfo{};
         std::vector<StackThreshold> stackThresholds{};
@@ -2475,14 +2722,20 @@ namespace Projections {
         std::vector<std::string> rawTags{};
         std::vector<FrameMask> masks{};
         AudioInfo audioInfo;
+        QuantizeInfo quantize{};
+        // Only lives for the duration of a single analysis pass and its consumers.
+        FrameAnalysis analysis{};
 
         bool prepared;
 
         void reset() {
             material.reset();
             audioInfo.reset();
+            quantize.reset();
             frames.clear();
             layers.clear();
+            sheets.clear();
+            streams.clear();
 
             masks.clear();
 
@@ -2537,6 +2790,26 @@ namespace Projections {
                     }
                 }
 
+                auto& sheetS = JCore::IO::getObject(jsonF, "sheets");
+                if (sheetS.is_array() && sheetS.size() > 0) {
+                    sheets.reserve(sheetS.size());
+                    for (size_t i = 0; i < sheetS.size(); i++) {
+                        if (sheetS[i].is_object()) {
+                            sheets.emplace_back().read(sheetS[i]);
+                        }
+                    }
+                }
+
+                auto& streamS = JCore::IO::getObject(jsonF, "streams");
+                if (streamS.is_array() && streamS.size() > 0) {
+                    streams.reserve(streamS.size());
+                    for (size_t i = 0; i < streamS.size(); i++) {
+                        if (streamS[i].is_object()) {
+                            streams.emplace_back().read(streamS[i]);
+                        }
+                    }
+                }
+
                 auto& fInfo = JCore::IO::getObject(jsonF, "frameInfo");
                 if (fInfo.is_array() && fInfo.size() > 0) {
                     frameInfo.reserve(fInfo.size());
@@ -2577,6 +2850,7 @@ namespace Projections {
                     }
                 }
                 audioInfo.read(JCore::IO::getObject(jsonF, "audio"));
+                quantize.read(JCore::IO::getObject(jsonF, "quantize"));
 
                 refreshTags();
                 return true;
@@ -2597,6 +2871,22 @@ namespace Projections {
             }
             jsonF["layers"] = lrs;
 
+            if (sheets.size() > 0) {
+                json::array_t sheetS = json::array_t{};
+                for (auto& sheet : sheets) {
+                    sheet.write(sheetS.emplace_back());
+                }
+                jsonF["sheets"] = sheetS;
+            }
+
+            if (streams.size() > 0) {
+                json::array_t streamS = json::array_t{};
+                for (auto& stream : streams) {
+                    stream.write(streamS.emplace_back());
+                }
+                jsonF["streams"] = streamS;
+            }
+
             json::array_t fInfo = json::array_t{};
             for (auto& fi : frameInfo) {
                 fi.write(fInfo.emplace_back());
@@ -2621,10 +2911,19 @@ namespace Projections {
             }
             jsonF["stackThresholds"] = stackT;
             audioInfo.write(jsonF["audio"]);
+            quantize.write(jsonF["quantize"]);
         }
 
-        bool prepare();
+        // Frames are listed from 'index' if it covers the frame path, otherwise the directory is walked.
+        bool prepare(const FileIndex* index = nullptr);
         bool write(const Stream& stream, PBuffers& buffers, float minCompression = 0.25f);
+        // Registers the content of every frame with 'store' so frames used by several projections can be shared.
+        // Only the keys are gathered, nothing decoded is kept once it returns.
+        void collectFrames(FrameStore& store, uint32_t owner);
+        // Decodes every frame once, collecting FrameStore keys and/or colors into 'analysis'.
+        void analyzeFrames(std::string_view root, bool withKeys, bool withColors);
+        // Drops the decoded pixels of every sprite sheet the frames are sliced from.
+        void releaseSheets();
 
         void removeTagAt(size_t i) {
             if (i >= tags.size()) { return; }
@@ -2637,6 +2936,35 @@ namespace Projections {
             tags.insert(tags.begin() + i, copy);
         }
 
+        void removeSheetAt(size_t i) {
+            if (i >= sheets.size()) { return; }
+            sheets.erase(sheets.begin() + i);
+        }
+
+        void duplicateSheetAt(size_t i) {
+            if (i >= sheets.size()) { return; }
+            SpriteSheet copy = sheets[i];
+            sheets.insert(sheets.begin() + i, copy);
+        }
+
+        bool usesStdin() const {
+            for (auto& stream : streams) {
+                if (stream.isStdin()) { return true; }
+            }
+            return false;
+        }
+
+        void removeStreamAt(size_t i) {
+            if (i >= streams.size()) { return; }
+            streams.erase(streams.begin() + i);
+        }
+
+        void duplicateStreamAt(size_t i) {
+            if (i >= streams.size()) { return; }
+            RawStream copy = streams[i];
+            streams.insert(streams.begin() + i, copy);
+        }
+
         void removeMaskAt(size_t i) {
             if (i >= masks.size()) { return; }
             masks.erase(masks.begin() + i);
@@ -2663,6 +2991,11 @@ namespace JCore {
         "Next Valid",
         "Specific Frame");
 
+    DEFINE_ENUM(Projections::DitherMode, false, 0, Projections::DitherMode::DITHER_COUNT,
+        "None",
+        "Ordered",
+        "Floyd-Steinberg");
+
     DEFINE_ENUM(Projections::PoolType, false, 0, Projections::PoolType::Pool_COUNT,
         "None",
         "Trader",
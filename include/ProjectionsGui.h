@@ -2,6 +2,7 @@
 #include <J-Core/Gui/IGuiExtras.h>
 #include <ProjectionGen.h>
 #include <J-Core/Util/StringUtils.h>
+#include <unordered_set>
 
 namespace Projections {
 
@@ -145,35 +146,9 @@ namespace Projections {
         PBuffers& getBuffers() { return _buffers; }
         std::vector<ProjectionSource>& getSources() { return _sources; }
 
-        bool isAlreadyLoaded(std::wstring_view view, size_t curI, int32_t mode)  const {
-            using namespace JCore;
-            for (size_t i = 0; i < curI; i++) {
-                auto& source = _sources[i];
-                switch (mode) {
-                    default:
-                        for (auto& p : source.projections) {
-                            if (IO::pathsMatch(p.path, view, false)) {
-                                return true;
-                            }
-                        }
-                        break;
-                case MODE_PMATERIAL:
-                    for (auto& p : source.materials) {
-                        if (IO::pathsMatch(p.path, view, false)) {
-                            return true;
-                        }
-                    }
-                    break;
-                case MODE_PBUNDLE:
-                    for (auto& p : source.bundles) {
-                        if (IO::pathsMatch(p.path, view, false)) {
-                            return true;
-                        }
-                    }
-                    break;
-                }
-            }
-            return false;
+        // True if a source before the one being loaded already has this config.
+        bool isAlreadyLoaded(std::string_view path, int32_t mode) const {
+            return _loadedKeys[mode].count(FileIndex::makeKey(path)) > 0;
         }
 
     private:
@@ -184,30 +159,48 @@ namespace Projections {
         size_t _loadedMaterials;
         size_t _loadedBundles;
         PBuffers _buffers;
+        // Keys of every config of the sources loaded so far, by mode.
+        std::unordered_set<std::string> _loadedKeys[3]{};
 
         void loadSettings();
         void saveSettings();
 
         void load();
 
+        void addLoadedKeys(const ProjectionSource& source) {
+            for (auto& item : source.projections) {
+                _loadedKeys[MODE_PROJECTION].insert(FileIndex::makeKey(item.path));
+            }
+            for (auto& item : source.materials) {
+                _loadedKeys[MODE_PMATERIAL].insert(FileIndex::makeKey(item.path));
+            }
+            for (auto& item : source.bundles) {
+                _loadedKeys[MODE_PBUNDLE].insert(FileIndex::makeKey(item.path));
+            }
+        }
+
+        // Returns -2 if 'path' is or is inside of a source, the index of a source inside of 'path', or -1.
         int32_t alreadyHasSource(std::string_view path, size_t ignore = SIZE_MAX) const {
+            std::string key = FileIndex::makeKey(path);
             for (size_t i = 0; i < _sources.size(); i++) {
                 if (ignore == i) { continue; }
-                auto& src = _sources[i];
-                auto rootA = JCore::IO::eraseRoot(path, src.path, true);
+                std::string srcKey = FileIndex::makeKey(_sources[i].path);
 
-                if (rootA.length() < path.length()) {
+                if (isSameOrBelow(key, srcKey)) {
                     return -2;
                 }
 
-                rootA = JCore::IO::eraseRoot(src.path, path, true);
-                if (rootA.length() < src.path.length()) {
+                if (isSameOrBelow(srcKey, key)) {
                     return int32_t(i);
                 }
             }
             return -1;
         }
 
+        static bool isSameOrBelow(std::string_view path, std::string_view dir) {
+            return path.substr(0, dir.length()) == dir && (path.length() == dir.length() || path[dir.length()] == '/');
+        }
+
         ProjectionSource* addSource(std::string_view path) {
             if (JCore::IO::exists(path)) {
                 if (fs::is_directory(path) || JCore::Utils::endsWith(path, ".txt")) {
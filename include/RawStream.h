@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include <J-Core/IO/ImageUtils.h>
+#include <MappedFile.h>
+
+namespace Projections {
+    // Reads all of stdin into a temporary file that every stream of stdin ("-") maps, frames are
+    // visited more than once while writing so it can't be read as it comes in. Blocks until stdin
+    // is closed, later calls return right away. Not thread safe, call it before preparing in parallel.
+    bool spoolStdin();
+
+    // Raw RGBA32 frames stored back to back, shared by every frame read out of it.
+    // Files are mapped as is, stdin has to be spooled with 'spoolStdin' first.
+    class StreamSource {
+    public:
+        StreamSource(std::string_view path, int32_t width, int32_t height);
+        StreamSource(const StreamSource&) = delete;
+        StreamSource& operator=(const StreamSource&) = delete;
+        ~StreamSource() { close(); }
+
+        const std::string& getPath() const { return _path; }
+        int32_t getWidth() const { return _width; }
+        int32_t getHeight() const { return _height; }
+        size_t getFrameCount() const { return _frameCount; }
+
+        // Reads at most 'maxFrames' frames, 0 reads every whole frame available.
+        bool open(std::string_view root, size_t maxFrames);
+        void close();
+
+        // Copies a frame into 'img' as RGBA32, thread safe.
+        bool readFrame(size_t frame, JCore::ImageData& img) const;
+
+    private:
+        std::string _path{};
+        int32_t _width{};
+        int32_t _height{};
+        size_t _frameCount{};
+        MappedFile _file{};
+    };
+
+    // Entry of "streams" in P-Data.json, maps the frames of a raw RGBA32 stream to consecutive frames of a layer.
+    // 'width' and 'height' are required as the stream has no header, a 'frameCount' of 0 reads the whole stream.
+    struct RawStream {
+        std::string path{};
+        int32_t layer{};
+        bool emission{};
+        int32_t startFrame{};
+        int32_t width{};
+        int32_t height{};
+        int32_t frameCount{};
+
+        void reset();
+        void read(const nlohmann::json& jsonF);
+        void write(nlohmann::json& jsonF) const;
+
+        bool isStdin() const { return path == "-"; }
+    };
+}
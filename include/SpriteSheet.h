@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <J-Core/IO/ImageUtils.h>
+#include <J-Core/Util/DataFormatUtils.h>
+
+namespace Projections {
+    struct SheetRect {
+        int32_t x{};
+        int32_t y{};
+        int32_t width{};
+        int32_t height{};
+    };
+
+    // A sprite sheet file shared by every frame sliced out of it.
+    // The sheet is decoded once on first use and kept as RGBA32 until released.
+    class SheetSource {
+    public:
+        SheetSource(std::string_view path);
+        SheetSource(const SheetSource&) = delete;
+        SheetSource& operator=(const SheetSource&) = delete;
+        ~SheetSource() { release(); }
+
+        const std::string& getPath() const { return _path; }
+
+        // Copies 'rect' out of the sheet into 'img' as RGBA32, thread safe.
+        bool slice(const SheetRect& rect, std::string_view root, JCore::ImageData& img);
+        void release();
+
+    private:
+        std::string _path{};
+        JCore::DataFormat _format{};
+        std::mutex _mutex{};
+        JCore::ImageData _image{};
+        bool _loaded{};
+        bool _failed{};
+
+        bool load(std::string_view root);
+    };
+
+    // Entry of "sheets" in P-Data.json, maps the cells of one sheet to consecutive frames of a layer.
+    // Cells come from 'atlas' if set, otherwise from a grid of 'frameWidth' x 'frameHeight' cells,
+    // 'spacing' pixels apart, read left to right and top to bottom.
+    // 'columns' and 'frameCount' of 0 fill the whole sheet.
+    struct SpriteSheet {
+        std::string path{};
+        std::string atlas{};
+        int32_t layer{};
+        bool emission{};
+        int32_t startFrame{};
+        int32_t frameWidth{};
+        int32_t frameHeight{};
+        int32_t columns{};
+        int32_t frameCount{};
+        int32_t spacing{};
+
+        void reset();
+        void read(const nlohmann::json& jsonF);
+        void write(nlohmann::json& jsonF) const;
+
+        // Resolves the cells in frame order, cells outside of the sheet are dropped.
+        bool getCells(std::string_view root, std::vector<SheetRect>& cells) const;
+    };
+}
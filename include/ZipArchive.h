@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <MappedFile.h>
+
+namespace Projections {
+    // Read only ZIP archive over a memory mapping of the whole file.
+    // Entries are listed from the central directory (ZIP64 included) and extracted on demand,
+    // stored and deflated entries are supported. Reads never modify the archive so any number
+    // of threads can extract entries at the same time.
+    class ZipArchive {
+    public:
+        struct Entry {
+            std::string name{};
+            uint64_t localOffset{};
+            uint64_t compressedSize{};
+            uint64_t size{};
+            uint32_t crc{};
+            uint16_t method{};
+            uint16_t flags{};
+        };
+
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return _file.isOpen(); }
+        const std::string& getPath() const { return _path; }
+
+        size_t getEntryCount() const { return _entries.size(); }
+        const Entry& getEntry(size_t index) const { return _entries[index]; }
+        // Returns SIZE_MAX if there's no entry of that name.
+        size_t find(std::string_view name) const;
+
+        // Extracts an entry into 'data' and checks its CRC.
+        bool read(size_t index, std::vector<uint8_t>& data) const;
+        // Extracts only the first 'maxSize' bytes of an entry, or all of it if it's smaller.
+        // Only inflates as much as that takes, the CRC can't be checked.
+        bool readPrefix(size_t index, size_t maxSize, std::vector<uint8_t>& data) const;
+
+    private:
+        std::string _path{};
+        MappedFile _file{};
+        std::vector<Entry> _entries{};
+        std::unordered_map<std::string_view, size_t> _lookup{};
+
+        bool readCentralDirectory();
+        // Start of an entry's data, null if its headers are invalid or it's encrypted.
+        const uint8_t* getEntryData(const Entry& entry) const;
+    };
+}
@@ -0,0 +1,151 @@
+#include <FileIndex.h>
+#include <ParallelUtils.h>
+#include <algorithm>
+#include <filesystem>
+#include <J-Core/TaskManager.h>
+namespace fs = std::filesystem;
+
+namespace Projections {
+    static bool isBelow(std::string_view path, std::string_view dir) {
+        return path.length() > dir.length() && path[dir.length()] == '/' && path.substr(0, dir.length()) == dir;
+    }
+
+    std::string FileIndex::normalize(std::string_view path) {
+        std::string norm = fs::path(path).lexically_normal().generic_string();
+        while (norm.length() > 1 && norm.back() == '/') {
+            norm.pop_back();
+        }
+        return norm;
+    }
+
+    std::string FileIndex::makeKey(std::string_view path) {
+        std::string key = normalize(path);
+#ifdef _WIN32
+        for (auto& c : key) {
+            if (c >= 'A' && c <= 'Z') {
+                c = char(c - 'A' + 'a');
+            }
+        }
+#endif
+        return key;
+    }
+
+    void FileIndex::clear() {
+        _roots.clear();
+        _entries.clear();
+    }
+
+    // Lists one directory, its files go to 'files' and its sub directories to 'dirs'.
+    // Stops where it is if the task is canceled.
+    static void scanDirectory(const std::string& dir, std::vector<FileIndex::Entry>& files, std::vector<std::string>& dirs) {
+        std::error_code err{};
+        fs::directory_iterator it(fs::path(dir), fs::directory_options::skip_permission_denied, err);
+        for (; !err && it != fs::directory_iterator(); it.increment(err)) {
+            if (JCore::TaskManager::isCanceling()) { return; }
+
+            const fs::directory_entry& entry = *it;
+            std::error_code entryErr{};
+            if (entry.is_directory(entryErr)) {
+                // Like a recursive directory iterator, linked directories aren't followed.
+                if (!entry.is_symlink(entryErr)) {
+                    dirs.emplace_back(entry.path().generic_string());
+                }
+                continue;
+            }
+            if (!entry.is_regular_file(entryErr)) { continue; }
+
+            auto& file = files.emplace_back();
+            file.path = entry.path().generic_string();
+            file.size = uint64_t(entry.file_size(entryErr));
+            if (entryErr) { file.size = 0; }
+            file.modified = int64_t(entry.last_write_time(entryErr).time_since_epoch().count());
+
+            size_t slash = file.path.find_last_of('/');
+            file.nameStart = uint32_t(slash == std::string::npos ? 0 : slash + 1);
+            size_t dot = file.path.find_last_of('.');
+            file.extStart = uint32_t(dot == std::string::npos || dot < file.nameStart ? file.path.length() : dot + 1);
+        }
+    }
+
+    void FileIndex::build(const std::vector<std::string>& roots) {
+        clear();
+        for (auto& root : roots) {
+            std::string norm = normalize(root);
+            if (std::find(_roots.begin(), _roots.end(), norm) == _roots.end()) {
+                _roots.emplace_back(std::move(norm));
+            }
+        }
+
+        // Crawled a level at a time, every directory of a level is listed in parallel.
+        std::vector<std::string> level{};
+        for (auto& root : _roots) {
+            bool nested = false;
+            for (auto& other : _roots) {
+                nested |= isBelow(root, other);
+            }
+            if (!nested) {
+                level.push_back(root);
+            }
+        }
+
+        struct Listing {
+            std::vector<Entry> files{};
+            std::vector<std::string> dirs{};
+        };
+
+        std::vector<Listing> listings{};
+        while (level.size() > 0) {
+            listings.clear();
+            listings.resize(level.size());
+            parallelFor(level.size(), getWorkerCount(), [&](size_t i, size_t) {
+                if (JCore::TaskManager::isCanceling()) { return; }
+                scanDirectory(level[i], listings[i].files, listings[i].dirs);
+                });
+
+            // A partial crawl would claim to cover directories it never finished listing.
+            if (JCore::TaskManager::isCanceling()) {
+                clear();
+                return;
+            }
+
+            level.clear();
+            for (auto& listing : listings) {
+                for (auto& file : listing.files) {
+                    _entries.emplace_back(std::move(file));
+                }
+                for (auto& dir : listing.dirs) {
+                    level.emplace_back(std::move(dir));
+                }
+            }
+        }
+
+        std::sort(_entries.begin(), _entries.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.path < rhs.path;
+            });
+    }
+
+    bool FileIndex::covers(std::string_view dir) const {
+        std::string norm = normalize(dir);
+        for (auto& root : _roots) {
+            if (norm == root || isBelow(norm, root)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool FileIndex::getFiles(std::string_view dir, std::vector<const Entry*>& files) const {
+        if (!covers(dir)) { return false; }
+
+        std::string prefix = normalize(dir);
+        prefix.push_back('/');
+        auto it = std::lower_bound(_entries.begin(), _entries.end(), prefix, [](const Entry& entry, const std::string& value) {
+            return entry.path < value;
+            });
+
+        for (; it != _entries.end() && it->path.compare(0, prefix.length(), prefix) == 0; ++it) {
+            files.push_back(&*it);
+        }
+        return true;
+    }
+}
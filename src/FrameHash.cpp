@@ -0,0 +1,207 @@
+#include <FrameHash.h>
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FRAME_HASH_SSE42
+#else
+#include <cpuid.h>
+#define FRAME_HASH_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+namespace Projections {
+    namespace detail {
+        // Slicing-by-8 tables for the reflected Castagnoli polynomial, the same CRC the
+        // SSE4.2 'crc32' instruction computes.
+        struct CRC32CTable {
+            uint32_t table[8][256]{};
+
+            CRC32CTable() {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t crc = i;
+                    for (int32_t j = 0; j < 8; j++) {
+                        crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 0x1)));
+                    }
+                    table[0][i] = crc;
+                }
+
+                for (uint32_t i = 0; i < 256; i++) {
+                    for (int32_t j = 1; j < 8; j++) {
+                        table[j][i] = (table[j - 1][i] >> 8) ^ table[0][table[j - 1][i] & 0xFF];
+                    }
+                }
+            }
+
+            inline uint32_t update(uint32_t crc, uint64_t word) const {
+                uint32_t lo = crc ^ uint32_t(word);
+                uint32_t hi = uint32_t(word >> 32);
+                return
+                    table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+                    table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+                    table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+                    table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+            }
+
+            inline uint32_t update(uint32_t crc, uint8_t byte) const {
+                return table[0][(crc ^ byte) & 0xFF] ^ (crc >> 8);
+            }
+        };
+
+        static const CRC32CTable& getCRC32CTable() {
+            static CRC32CTable table{};
+            return table;
+        }
+
+        static inline uint64_t readWord(const uint8_t* data) {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+            return word;
+        }
+
+        // Zero in, zero out, so leading zero words leave a lane at zero like CRC does.
+        static inline uint64_t mixCheck(uint64_t check, uint64_t word) {
+            check = (check ^ word) * 0x9E3779B97F4A7C15ULL;
+            return check ^ (check >> 29);
+        }
+
+        // Trailing bytes that don't fill a word are mixed as one zero padded word.
+        static inline uint64_t readTail(const uint8_t* data, size_t size) {
+            uint64_t word = 0;
+            memcpy(&word, data, size);
+            return word;
+        }
+
+        static void hashScalar(uint32_t* lanes, uint64_t* checks, const uint8_t* data, size_t size) {
+            const CRC32CTable& crc = getCRC32CTable();
+            uint32_t l0 = lanes[0], l1 = lanes[1], l2 = lanes[2], l3 = lanes[3];
+            uint64_t c0 = checks[0], c1 = checks[1], c2 = checks[2], c3 = checks[3];
+
+            size_t stripes = size / FrameHash::STRIDE;
+            for (size_t i = 0; i < stripes; i++, data += FrameHash::STRIDE) {
+                uint64_t w0 = readWord(data);
+                uint64_t w1 = readWord(data + 8);
+                uint64_t w2 = readWord(data + 16);
+                uint64_t w3 = readWord(data + 24);
+                l0 = crc.update(l0, w0);
+                l1 = crc.update(l1, w1);
+                l2 = crc.update(l2, w2);
+                l3 = crc.update(l3, w3);
+                c0 = mixCheck(c0, w0);
+                c1 = mixCheck(c1, w1);
+                c2 = mixCheck(c2, w2);
+                c3 = mixCheck(c3, w3);
+            }
+            lanes[0] = l0;
+            lanes[1] = l1;
+            lanes[2] = l2;
+            lanes[3] = l3;
+            checks[0] = c0;
+            checks[1] = c1;
+            checks[2] = c2;
+            checks[3] = c3;
+
+            size -= stripes * FrameHash::STRIDE;
+            size_t lane = 0;
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t word = readWord(data);
+                lanes[lane] = crc.update(lanes[lane], word);
+                checks[lane] = mixCheck(checks[lane], word);
+                lane++;
+            }
+            for (size_t i = 0; i < size; i++) {
+                lanes[lane] = crc.update(lanes[lane], data[i]);
+            }
+            if (size > 0) {
+                checks[lane] = mixCheck(checks[lane], readTail(data, size));
+            }
+        }
+
+#if defined(_M_X64) || defined(__x86_64__)
+        FRAME_HASH_SSE42 static void hashSSE42(uint32_t* lanes, uint64_t* checks, const uint8_t* data, size_t size) {
+            uint64_t l0 = lanes[0], l1 = lanes[1], l2 = lanes[2], l3 = lanes[3];
+            uint64_t c0 = checks[0], c1 = checks[1], c2 = checks[2], c3 = checks[3];
+
+            size_t stripes = size / FrameHash::STRIDE;
+            for (size_t i = 0; i < stripes; i++, data += FrameHash::STRIDE) {
+                uint64_t w0 = readWord(data);
+                uint64_t w1 = readWord(data + 8);
+                uint64_t w2 = readWord(data + 16);
+                uint64_t w3 = readWord(data + 24);
+                l0 = _mm_crc32_u64(l0, w0);
+                l1 = _mm_crc32_u64(l1, w1);
+                l2 = _mm_crc32_u64(l2, w2);
+                l3 = _mm_crc32_u64(l3, w3);
+                c0 = mixCheck(c0, w0);
+                c1 = mixCheck(c1, w1);
+                c2 = mixCheck(c2, w2);
+                c3 = mixCheck(c3, w3);
+            }
+            lanes[0] = uint32_t(l0);
+            lanes[1] = uint32_t(l1);
+            lanes[2] = uint32_t(l2);
+            lanes[3] = uint32_t(l3);
+            checks[0] = c0;
+            checks[1] = c1;
+            checks[2] = c2;
+            checks[3] = c3;
+
+            size -= stripes * FrameHash::STRIDE;
+            size_t lane = 0;
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t word = readWord(data);
+                lanes[lane] = uint32_t(_mm_crc32_u64(lanes[lane], word));
+                checks[lane] = mixCheck(checks[lane], word);
+                lane++;
+            }
+            for (size_t i = 0; i < size; i++) {
+                lanes[lane] = _mm_crc32_u8(lanes[lane], data[i]);
+            }
+            if (size > 0) {
+                checks[lane] = mixCheck(checks[lane], readTail(data, size));
+            }
+        }
+#endif
+
+        static bool detectSSE42() {
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+            int32_t info[4]{};
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+#else
+            uint32_t eax{}, ebx{}, ecx{}, edx{};
+            return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2) != 0;
+#endif
+#else
+            return false;
+#endif
+        }
+    }
+
+    bool FrameHash::hasHardwareCRC() {
+        static const bool supported = detail::detectSSE42();
+        return supported;
+    }
+
+    void FrameHash::update(const uint8_t* data, size_t size) {
+        if (!data || size < 1) { return; }
+
+#if defined(_M_X64) || defined(__x86_64__)
+        if (hasHardwareCRC()) {
+            detail::hashSSE42(lanes, checks, data, size);
+            return;
+        }
+#endif
+        detail::hashScalar(lanes, checks, data, size);
+    }
+
+    void FrameHash::updateScalar(const uint8_t* data, size_t size) {
+        if (!data || size < 1) { return; }
+        detail::hashScalar(lanes, checks, data, size);
+    }
+
+    bool FrameHash::from(const uint8_t* data, size_t size) {
+        clear();
+        update(data, size);
+        return !isZero();
+    }
+}
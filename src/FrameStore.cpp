@@ -0,0 +1,104 @@
+#include <FrameStore.h>
+#include <filesystem>
+#include <J-Core/IO/IOUtils.h>
+#include <J-Core/Log.h>
+using namespace JCore;
+
+namespace Projections {
+    void FrameStore::reset() {
+        close();
+        _owners.clear();
+        _sharedCount = 0;
+        _entries.clear();
+        _index.clear();
+        _compareBuffer.clear();
+        _compareBuffer.shrink_to_fit();
+        _reused = 0;
+        _dataSize = 0;
+    }
+
+    void FrameStore::addReference(uint64_t key, uint32_t owner) {
+        auto it = _owners.try_emplace(key, owner).first;
+        if (it->second != owner && it->second != SHARED_OWNER) {
+            it->second = SHARED_OWNER;
+            _sharedCount++;
+        }
+    }
+
+    bool FrameStore::isShared(uint64_t key) const {
+        auto it = _owners.find(key);
+        return it != _owners.end() && it->second == SHARED_OWNER;
+    }
+
+    bool FrameStore::open(const std::string& path) {
+        close();
+        _entries.clear();
+        _index.clear();
+        _reused = 0;
+        _dataSize = 0;
+
+        _path = path;
+        _pathTmp = path;
+        _pathTmp.append(".tmp");
+        if (!_stream.open(_pathTmp, "w+b")) {
+            JCORE_ERROR("Failed to open shared frame store '{}' for writing!", _pathTmp);
+            return false;
+        }
+
+        _stream.write(HEADER, 1, 4, false);
+        _stream.writeValue(VERSION);
+        _stream.writeValue<uint32_t>(0);
+        _stream.writeValue<uint64_t>(0);
+        return true;
+    }
+
+    bool FrameStore::close() {
+        if (!_stream.isOpen()) { return false; }
+
+        if (_entries.size() < 1) {
+            _stream.close();
+            std::filesystem::remove(_pathTmp);
+            return false;
+        }
+
+        uint64_t tableOffset = uint64_t(_stream.tell());
+        for (auto& entry : _entries) {
+            _stream.writeValue(entry.offset);
+            _stream.writeValue(entry.size);
+        }
+
+        _stream.seek(sizeof(uint32_t) * 2, SEEK_SET);
+        _stream.writeValue(uint32_t(_entries.size()));
+        _stream.writeValue(tableOffset);
+        _stream.close();
+
+        IO::moveFile(_pathTmp, _path, true);
+        return true;
+    }
+
+    uint32_t FrameStore::add(uint64_t key, const uint8_t* data, size_t size) {
+        auto range = _index.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it) {
+            const Entry& entry = _entries[it->second];
+            if (entry.size != size) { continue; }
+
+            _compareBuffer.resize(size);
+            size_t endPos = _stream.tell();
+            _stream.seek(entry.offset, SEEK_SET);
+            _stream.read(_compareBuffer.data(), size, 1);
+            _stream.seek(endPos, SEEK_SET);
+
+            if (memcmp(_compareBuffer.data(), data, size) == 0) {
+                _reused++;
+                return it->second;
+            }
+        }
+
+        uint32_t id = uint32_t(_entries.size());
+        _entries.push_back({ uint64_t(_stream.tell()), uint32_t(size) });
+        _stream.write(data, size, false);
+        _index.emplace(key, id);
+        _dataSize += size;
+        return id;
+    }
+}
@@ -0,0 +1,98 @@
+#include <MappedFile.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Projections {
+#ifdef _WIN32
+    bool MappedFile::open(const std::string& path, bool sequential) {
+        close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | (sequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0), nullptr);
+        if (file == INVALID_HANDLE_VALUE) { return false; }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart < 1) {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        _file = file;
+        _mapping = mapping;
+        _data = reinterpret_cast<const uint8_t*>(view);
+        _size = size_t(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping) {
+            CloseHandle(_mapping);
+        }
+        if (_file) {
+            CloseHandle(_file);
+        }
+        _data = nullptr;
+        _mapping = nullptr;
+        _file = nullptr;
+        _size = 0;
+    }
+#else
+    bool MappedFile::open(const std::string& path, bool sequential) {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return false; }
+
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size < 1) {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) { return false; }
+
+        if (sequential) {
+            madvise(view, size_t(info.st_size), MADV_SEQUENTIAL);
+            madvise(view, size_t(info.st_size), MADV_WILLNEED);
+        }
+
+        _data = reinterpret_cast<const uint8_t*>(view);
+        _size = size_t(info.st_size);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (_data) {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+#endif
+}
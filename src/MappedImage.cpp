@@ -0,0 +1,227 @@
+#include <MappedImage.h>
+#include <MappedFile.h>
+#include <PixelKernels.h>
+#include <PngDecoder.h>
+#include <cstring>
+#include <J-Core/IO/Image.h>
+#include <J-Core/Util/StringUtils.h>
+using namespace JCore;
+
+namespace Projections {
+    namespace detail {
+        template<typename T>
+        static inline T readAt(const uint8_t* data, size_t offset) {
+            T value;
+            memcpy(&value, data + offset, sizeof(T));
+            return value;
+        }
+
+        enum RowLayout : uint8_t {
+            ROW_RGBA32,
+            ROW_RGBX32,
+            ROW_BGRA32,
+            ROW_BGRX32,
+            ROW_RGB24,
+            ROW_BGR24,
+        };
+
+        static void convertRow(const uint8_t* src, Color32* dst, size_t count, RowLayout layout) {
+            switch (layout) {
+                case ROW_RGBA32:
+                    memcpy(dst, src, count * sizeof(Color32));
+                    break;
+                case ROW_RGBX32: {
+                    memcpy(dst, src, count * sizeof(Color32));
+                    uint32_t* values = reinterpret_cast<uint32_t*>(dst);
+                    for (size_t i = 0; i < count; i++) {
+                        values[i] |= 0xFF000000U;
+                    }
+                    break;
+                }
+                case ROW_BGRA32: Kernels::swizzleBGRA32(src, dst, count, false); break;
+                case ROW_BGRX32: Kernels::swizzleBGRA32(src, dst, count, true); break;
+                case ROW_RGB24:  Kernels::expandRGB24(src, dst, count); break;
+                case ROW_BGR24:  Kernels::expandBGR24(src, dst, count); break;
+            }
+        }
+
+        struct MappedLayout {
+            int32_t width{};
+            int32_t height{};
+            size_t offset{};
+            size_t stride{};
+            bool bottomUp{};
+            RowLayout layout{};
+        };
+
+        static bool parseBMP(const uint8_t* data, size_t size, MappedLayout& info) {
+            if (size < 54 || data[0] != 'B' || data[1] != 'M') { return false; }
+
+            uint32_t offBits = readAt<uint32_t>(data, 10);
+            uint32_t hdrSize = readAt<uint32_t>(data, 14);
+            int32_t width = readAt<int32_t>(data, 18);
+            int32_t height = readAt<int32_t>(data, 22);
+            uint16_t bpp = readAt<uint16_t>(data, 28);
+            uint32_t compression = readAt<uint32_t>(data, 30);
+            if (hdrSize < 40 || width < 1 || height == 0 || height == INT32_MIN) { return false; }
+
+            if (bpp == 24 && compression == 0) {
+                info.layout = ROW_BGR24;
+            }
+            else if (bpp == 32 && compression == 3 && hdrSize >= 56 && size >= 70 &&
+                readAt<uint32_t>(data, 54) == 0x00FF0000U && readAt<uint32_t>(data, 58) == 0x0000FF00U &&
+                readAt<uint32_t>(data, 62) == 0x000000FFU && readAt<uint32_t>(data, 66) == 0xFF000000U) {
+                info.layout = ROW_BGRA32;
+            }
+            else {
+                // Palettized, RLE and 32-bit BI_RGB (alpha meaning varies) are left to J-Core.
+                return false;
+            }
+
+            info.width = width;
+            info.height = height < 0 ? -height : height;
+            info.bottomUp = height > 0;
+            info.offset = offBits;
+            info.stride = ((size_t(width) * bpp + 31) / 32) * 4;
+            return true;
+        }
+
+        static bool parseDDS(const uint8_t* data, size_t size, MappedLayout& info) {
+            static constexpr uint32_t DDSD_PITCH = 0x8;
+            static constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+            static constexpr uint32_t DDPF_FOURCC = 0x4;
+            static constexpr uint32_t DDPF_RGB = 0x40;
+
+            if (size < 128 || memcmp(data, "DDS ", 4) != 0 || readAt<uint32_t>(data, 4) != 124) { return false; }
+
+            uint32_t flags = readAt<uint32_t>(data, 8);
+            int32_t height = readAt<int32_t>(data, 12);
+            int32_t width = readAt<int32_t>(data, 16);
+            uint32_t pitch = readAt<uint32_t>(data, 20);
+            uint32_t pfFlags = readAt<uint32_t>(data, 80);
+            uint32_t bpp = readAt<uint32_t>(data, 88);
+            uint32_t rMask = readAt<uint32_t>(data, 92);
+            uint32_t gMask = readAt<uint32_t>(data, 96);
+            uint32_t bMask = readAt<uint32_t>(data, 100);
+            uint32_t aMask = readAt<uint32_t>(data, 104);
+
+            if (width < 1 || height < 1 || (pfFlags & DDPF_FOURCC) || !(pfFlags & DDPF_RGB) || gMask != 0x0000FF00U) { return false; }
+
+            bool isRGB = rMask == 0x000000FFU && bMask == 0x00FF0000U;
+            bool isBGR = rMask == 0x00FF0000U && bMask == 0x000000FFU;
+            bool hasAlpha = (pfFlags & DDPF_ALPHAPIXELS) && aMask == 0xFF000000U;
+            if (!isRGB && !isBGR) { return false; }
+
+            switch (bpp) {
+                case 32:
+                    info.layout = isRGB ? (hasAlpha ? ROW_RGBA32 : ROW_RGBX32) : (hasAlpha ? ROW_BGRA32 : ROW_BGRX32);
+                    break;
+                case 24:
+                    info.layout = isRGB ? ROW_RGB24 : ROW_BGR24;
+                    break;
+                default:
+                    return false;
+            }
+
+            info.width = width;
+            info.height = height;
+            info.bottomUp = false;
+            info.offset = 128;
+            info.stride = (flags & DDSD_PITCH) && pitch >= size_t(width) * (bpp >> 3) ? pitch : size_t(width) * (bpp >> 3);
+            return true;
+        }
+
+        static bool decodeLayout(const uint8_t* data, size_t size, const MappedLayout& info, ImageData& img) {
+            size_t rowBytes = size_t(info.width) * (info.layout >= ROW_RGB24 ? 3 : 4);
+            if (info.offset > size || info.stride < rowBytes ||
+                (size - info.offset) / info.stride < size_t(info.height) - 1 ||
+                size - info.offset - info.stride * (size_t(info.height) - 1) < rowBytes) {
+                return false;
+            }
+
+            if (!img.doAllocate(info.width, info.height, TextureFormat::RGBA32)) { return false; }
+
+            Color32* pixels = reinterpret_cast<Color32*>(img.data);
+            const uint8_t* src = data + info.offset;
+            for (int32_t y = 0; y < info.height; y++) {
+                int32_t row = info.bottomUp ? info.height - 1 - y : y;
+                convertRow(src + size_t(row) * info.stride, pixels + size_t(y) * info.width, size_t(info.width), info.layout);
+            }
+            return true;
+        }
+
+        static bool decodeBuffer(const uint8_t* data, size_t size, DataFormat format, ImageData& img) {
+            MappedLayout info{};
+            switch (format) {
+                case FMT_PNG: return PngDecoder::decode(data, size, img);
+                case FMT_BMP: return parseBMP(data, size, info) && decodeLayout(data, size, info, img);
+                case FMT_DDS: return parseDDS(data, size, info) && decodeLayout(data, size, info, img);
+                default: return false;
+            }
+        }
+
+        static bool decodeJCore(const std::string& path, DataFormat format, ImageData& img) {
+            switch (format)
+            {
+            case FMT_PNG:  return Png::decode(path.c_str(), img);
+            case FMT_BMP:  return Bmp::decode(path.c_str(), img);
+            case FMT_DDS:  return DDS::decode(path.c_str(), img);
+            case FMT_JTEX: return JTEX::decode(path.c_str(), img);
+            default: return false;
+            }
+        }
+    }
+
+    bool decodeMapped(const std::string& path, DataFormat format, ImageData& img) {
+        if (format != FMT_PNG && format != FMT_BMP && format != FMT_DDS) { return false; }
+
+        MappedFile file{};
+        return file.open(path) && detail::decodeBuffer(file.data(), file.size(), format, img);
+    }
+
+    bool decodeImageMemory(const uint8_t* data, size_t size, DataFormat format, ImageData& img) {
+        return detail::decodeBuffer(data, size, format, img);
+    }
+
+    bool getImageMemoryInfo(const uint8_t* data, size_t size, DataFormat format, ImageData& img) {
+        using namespace detail;
+        if (format == FMT_PNG) {
+            return PngDecoder::getInfo(data, size, img);
+        }
+
+        MappedLayout info{};
+        switch (format) {
+            case FMT_BMP: if (!parseBMP(data, size, info)) { return false; } break;
+            case FMT_DDS: if (!parseDDS(data, size, info)) { return false; } break;
+            default: return false;
+        }
+
+        img.width = info.width;
+        img.height = info.height;
+        img.format = (info.layout == ROW_RGBA32 || info.layout == ROW_BGRA32) ? TextureFormat::RGBA32 : TextureFormat::RGB24;
+        return true;
+    }
+
+    DataFormat getImageFormat(std::string_view path) {
+        if (Utils::endsWith(path, ".png", false)) { return FMT_PNG; }
+        if (Utils::endsWith(path, ".bmp", false)) { return FMT_BMP; }
+        if (Utils::endsWith(path, ".dds", false)) { return FMT_DDS; }
+        if (Utils::endsWith(path, ".jtex", false)) { return FMT_JTEX; }
+        return FMT_UNKNOWN;
+    }
+
+    bool decodeImageFile(const std::string& path, DataFormat format, ImageData& img) {
+        return decodeMapped(path, format, img) || detail::decodeJCore(path, format, img);
+    }
+
+    bool getImageFileInfo(const std::string& path, DataFormat format, ImageData& img) {
+        switch (format)
+        {
+        case FMT_PNG:  return Png::getInfo(path.c_str(), img);
+        case FMT_BMP:  return Bmp::getInfo(path.c_str(), img);
+        case FMT_DDS:  return DDS::getInfo(path.c_str(), img);
+        case FMT_JTEX: return JTEX::getInfo(path.c_str(), img);
+        default: return false;
+        }
+    }
+}
@@ -0,0 +1,500 @@
+#include <PaletteQuantizer.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <J-Core/Math/Math.h>
+
+using namespace JCore;
+
+namespace Projections {
+    // Colors are compared in Oklab with alpha as a fourth axis. Every axis is scaled
+    // so a plain squared distance works: L spans 0 to LAB_SCALE, a and b stay within
+    // about +-LAB_SCALE / 2 and alpha spans 0 to LAB_SCALE like L.
+    static constexpr float LAB_SCALE = 510.0f;
+    static constexpr float ALPHA_SCALE = LAB_SCALE / 255.0f;
+    static constexpr int32_t KMEANS_PASSES = 4;
+
+    static inline uint32_t toUI32(Color32 color) {
+        return reinterpret_cast<const uint32_t&>(color);
+    }
+
+    static inline Color32 fromUI32(uint32_t value) {
+        return reinterpret_cast<const Color32&>(value);
+    }
+
+    struct LabColor {
+        float v[4];
+    };
+
+    static inline float toLinear(uint8_t value) {
+        static const auto table = []() {
+            std::array<float, 256> values{};
+            for (int32_t i = 0; i < 256; i++) {
+                double c = i / 255.0;
+                values[i] = float(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+            }
+            return values;
+        }();
+        return table[value];
+    }
+
+    static inline uint8_t fromLinear(float value) {
+        double c = Math::clamp(double(value), 0.0, 1.0);
+        c = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+        return uint8_t(c * 255.0 + 0.5);
+    }
+
+    static LabColor toLab(Color32 color) {
+        float r = toLinear(color.r);
+        float g = toLinear(color.g);
+        float b = toLinear(color.b);
+
+        float l = std::cbrt(0.4122214708f * r + 0.5363486232f * g + 0.0514459929f * b);
+        float m = std::cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+        float s = std::cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+        return LabColor{ {
+            (0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s) * LAB_SCALE,
+            (1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s) * LAB_SCALE,
+            (0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s) * LAB_SCALE,
+            color.a * ALPHA_SCALE,
+        } };
+    }
+
+    static Color32 fromLab(const LabColor& lab) {
+        float L = lab.v[0] / LAB_SCALE;
+        float A = lab.v[1] / LAB_SCALE;
+        float B = lab.v[2] / LAB_SCALE;
+
+        float l = L + 0.3963377774f * A + 0.2158037573f * B;
+        float m = L - 0.1055613458f * A - 0.0638541728f * B;
+        float s = L - 0.0894841775f * A - 1.2914855480f * B;
+        l = l * l * l;
+        m = m * m * m;
+        s = s * s * s;
+
+        // Opaque palette entries never collapse into the transparent one.
+        return Color32(
+            fromLinear(4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s),
+            fromLinear(-1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s),
+            fromLinear(-0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s),
+            uint8_t(Math::clamp(lab.v[3] / ALPHA_SCALE + 0.5f, 1.0f, 255.0f)));
+    }
+
+    static inline void toFixed(Color32 color, int16_t* out) {
+        LabColor lab = toLab(color);
+        for (int32_t c = 0; c < 4; c++) {
+            out[c] = int16_t(std::lround(lab.v[c]));
+        }
+    }
+
+    static inline int64_t sqDistance(Color32 lhs, Color32 rhs) {
+        int64_t r = int64_t(lhs.r) - rhs.r;
+        int64_t g = int64_t(lhs.g) - rhs.g;
+        int64_t b = int64_t(lhs.b) - rhs.b;
+        int64_t a = int64_t(lhs.a) - rhs.a;
+        return r * r + g * g + b * b + a * a;
+    }
+
+    void ColorHistogram::add(const Color32* pixels, size_t count) {
+        if (count < 1) { return; }
+
+        uint32_t prev = toUI32(pixels[0]);
+        uint32_t run = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t cur = toUI32(pixels[i]);
+            if (cur != prev) {
+                counts[prev] += run;
+                prev = cur;
+                run = 0;
+            }
+            run++;
+        }
+        counts[prev] += run;
+    }
+
+    void ColorHistogram::merge(const ColorHistogram& other) {
+        for (auto& pair : other.counts) {
+            counts[pair.first] += pair.second;
+        }
+    }
+
+    double QuantizeStats::getPSNR() const {
+        if (samples < 1 || sqError <= 0.0) {
+            return std::numeric_limits<double>::infinity();
+        }
+        double mse = sqError / double(samples);
+        return 10.0 * std::log10((255.0 * 255.0) / mse);
+    }
+
+    void PaletteQuantizer::clear() {
+        _colors.clear();
+        _simdCount = 0;
+        for (auto& entry : _cache) {
+            entry.color = 0;
+            entry.index = -1;
+        }
+    }
+
+    namespace detail {
+        struct HistEntry {
+            Color32 color;
+            LabColor lab;
+            uint64_t count;
+        };
+
+        struct ColorBox {
+            size_t begin;
+            size_t end;
+            int32_t axis;
+            double error;
+        };
+
+        static void evaluateBox(ColorBox& box, const HistEntry* entries) {
+            double sum[4]{};
+            double sumSq[4]{};
+            double total = 0;
+
+            for (size_t i = box.begin; i < box.end; i++) {
+                const auto& entry = entries[i];
+                double w = double(entry.count);
+                for (int32_t c = 0; c < 4; c++) {
+                    double v = entry.lab.v[c];
+                    sum[c] += v * w;
+                    sumSq[c] += v * v * w;
+                }
+                total += w;
+            }
+
+            box.axis = 0;
+            box.error = 0;
+            if (box.end - box.begin < 2 || total <= 0) { return; }
+
+            for (int32_t c = 0; c < 4; c++) {
+                double err = sumSq[c] - (sum[c] * sum[c]) / total;
+                if (err > box.error) {
+                    box.error = err;
+                    box.axis = c;
+                }
+            }
+        }
+
+        static Color32 averageBox(const ColorBox& box, const HistEntry* entries) {
+            double sum[4]{};
+            double total = 0;
+            for (size_t i = box.begin; i < box.end; i++) {
+                const auto& entry = entries[i];
+                for (int32_t c = 0; c < 4; c++) {
+                    sum[c] += double(entry.lab.v[c]) * double(entry.count);
+                }
+                total += double(entry.count);
+            }
+
+            total = Math::max(total, 1.0);
+            return fromLab(LabColor{ { float(sum[0] / total), float(sum[1] / total), float(sum[2] / total), float(sum[3] / total) } });
+        }
+    }
+
+    bool PaletteQuantizer::build(const ColorHistogram& histogram, int32_t maxColors) {
+        using namespace detail;
+        clear();
+
+        maxColors = Math::clamp(maxColors, 2, MAX_COLORS);
+        if (histogram.size() < 1) { return false; }
+
+        std::vector<HistEntry> entries{};
+        entries.reserve(histogram.size());
+
+        bool hasTransparent = false;
+        for (auto& pair : histogram.counts) {
+            Color32 color = fromUI32(pair.first);
+            if (color.a == 0) {
+                hasTransparent = true;
+                continue;
+            }
+            entries.push_back({ color, toLab(color), pair.second });
+        }
+
+        if (hasTransparent) {
+            _colors.push_back(Color32(0, 0, 0, 0));
+            maxColors--;
+        }
+
+        // Nothing to reduce, keep the colors exact.
+        if (entries.size() <= size_t(maxColors)) {
+            for (auto& entry : entries) {
+                _colors.push_back(entry.color);
+            }
+            refreshLookup();
+            return true;
+        }
+
+        std::vector<ColorBox> boxes{};
+        boxes.reserve(maxColors);
+        evaluateBox(boxes.emplace_back(ColorBox{ 0, entries.size(), 0, 0 }), entries.data());
+
+        while (boxes.size() < size_t(maxColors)) {
+            size_t target = SIZE_MAX;
+            double best = 0;
+            for (size_t i = 0; i < boxes.size(); i++) {
+                if (boxes[i].error > best) {
+                    best = boxes[i].error;
+                    target = i;
+                }
+            }
+            if (target == SIZE_MAX) { break; }
+
+            ColorBox box = boxes[target];
+            int32_t axis = box.axis;
+            auto begin = entries.begin() + box.begin;
+            auto end = entries.begin() + box.end;
+            std::sort(begin, end, [axis](const HistEntry& lhs, const HistEntry& rhs) {
+                return lhs.lab.v[axis] < rhs.lab.v[axis];
+                });
+
+            uint64_t total = 0;
+            for (size_t i = box.begin; i < box.end; i++) {
+                total += entries[i].count;
+            }
+
+            size_t split = box.begin + 1;
+            uint64_t acc = entries[box.begin].count;
+            while (split < box.end - 1 && acc < (total >> 1)) {
+                acc += entries[split++].count;
+            }
+
+            ColorBox lo{ box.begin, split, 0, 0 };
+            ColorBox hi{ split, box.end, 0, 0 };
+            evaluateBox(lo, entries.data());
+            evaluateBox(hi, entries.data());
+            boxes[target] = lo;
+            boxes.push_back(hi);
+        }
+
+        size_t first = _colors.size();
+        for (auto& box : boxes) {
+            _colors.push_back(averageBox(box, entries.data()));
+        }
+        refreshLookup();
+
+        // Refine the median cut result with weighted k-means, transparent entry stays fixed.
+        std::vector<double> sums{};
+        for (int32_t pass = 0; pass < KMEANS_PASSES; pass++) {
+            sums.assign(_colors.size() * 5, 0.0);
+            for (auto& entry : entries) {
+                int32_t ind = findNearest(entry.color);
+                double* sum = sums.data() + size_t(ind) * 5;
+                for (int32_t c = 0; c < 4; c++) {
+                    sum[c] += double(entry.lab.v[c]) * double(entry.count);
+                }
+                sum[4] += double(entry.count);
+            }
+
+            bool changed = false;
+            for (size_t i = first; i < _colors.size(); i++) {
+                const double* sum = sums.data() + i * 5;
+                if (sum[4] <= 0) { continue; }
+                Color32 mean = fromLab(LabColor{ {
+                    float(sum[0] / sum[4]), float(sum[1] / sum[4]), float(sum[2] / sum[4]), float(sum[3] / sum[4]) } });
+                changed |= mean != _colors[i];
+                _colors[i] = mean;
+            }
+
+            if (!changed) { break; }
+            refreshLookup();
+        }
+        return true;
+    }
+
+    double PaletteQuantizer::estimatePSNR(const ColorHistogram& histogram) const {
+        QuantizeStats stats{};
+        if (_colors.size() < 1) { return 0.0; }
+
+        for (auto& pair : histogram.counts) {
+            Color32 color = fromUI32(pair.first);
+            Color32 mapped = _colors[findNearest(color)];
+            stats.sqError += double(sqDistance(color, mapped)) * double(pair.second);
+            stats.samples += pair.second * 4;
+        }
+        return stats.getPSNR();
+    }
+
+    void PaletteQuantizer::refreshLookup() {
+        int32_t count = int32_t(_colors.size());
+        _simdCount = (count + 3) & ~3;
+
+        int16_t* data = reinterpret_cast<int16_t*>(_simdColors);
+        for (int32_t i = 0; i < _simdCount; i++) {
+            toFixed(_colors[Math::min(i, count - 1)], data + i * 4);
+        }
+
+        for (auto& entry : _cache) {
+            entry.color = 0;
+            entry.index = -1;
+        }
+    }
+
+    int32_t PaletteQuantizer::findNearest(Color32 color) const {
+        if (_simdCount < 1) { return -1; }
+        if (color.a == 0 && _colors[0].a == 0) { return 0; }
+
+        int16_t lab[4]{};
+        toFixed(color, lab);
+        const __m128i pixel = _mm_setr_epi16(
+            lab[0], lab[1], lab[2], lab[3],
+            lab[0], lab[1], lab[2], lab[3]);
+
+        __m128i bestDist = _mm_set1_epi32(INT32_MAX);
+        __m128i bestInd = _mm_setzero_si128();
+        __m128i curInd = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i step = _mm_set1_epi32(4);
+
+        const __m128i* simdPtr = _simdColors;
+        for (int32_t i = 0; i < _simdCount; i += 4) {
+            __m128i d0 = _mm_sub_epi16(pixel, *simdPtr++);
+            __m128i d1 = _mm_sub_epi16(pixel, *simdPtr++);
+            d0 = _mm_madd_epi16(d0, d0);
+            d1 = _mm_madd_epi16(d1, d1);
+
+            __m128i dist = _mm_hadd_epi32(d0, d1);
+            __m128i less = _mm_cmplt_epi32(dist, bestDist);
+            bestDist = _mm_min_epi32(dist, bestDist);
+            bestInd = _mm_blendv_epi8(bestInd, curInd, less);
+            curInd = _mm_add_epi32(curInd, step);
+        }
+
+        alignas(16) int32_t dists[4];
+        alignas(16) int32_t inds[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(dists), bestDist);
+        _mm_store_si128(reinterpret_cast<__m128i*>(inds), bestInd);
+
+        int32_t best = 0;
+        for (int32_t i = 1; i < 4; i++) {
+            if (dists[i] < dists[best] || (dists[i] == dists[best] && inds[i] < inds[best])) {
+                best = i;
+            }
+        }
+        return Math::min(inds[best], int32_t(_colors.size()) - 1);
+    }
+
+    int32_t PaletteQuantizer::findNearestCached(Color32 color) {
+        uint32_t key = toUI32(color);
+        CacheEntry& entry = _cache[((key * 0x9E3779B1U) >> 20) & (CACHE_SIZE - 1)];
+        if (entry.index > -1 && entry.color == key) {
+            return entry.index;
+        }
+        entry.color = key;
+        entry.index = findNearest(color);
+        return entry.index;
+    }
+
+    static inline uint8_t clampUI8(int32_t value) {
+        return uint8_t(value < 0 ? 0 : value > 255 ? 255 : value);
+    }
+
+    void PaletteQuantizer::apply(Color32* pixels, int32_t width, int32_t height, DitherMode dither, QuantizeStats* stats) {
+        static constexpr int32_t BAYER_4X4[16]{
+             0,  8,  2, 10,
+            12,  4, 14,  6,
+             3, 11,  1,  9,
+            15,  7, 13,  5,
+        };
+
+        if (_colors.size() < 1 || !pixels) { return; }
+
+        double sqError = 0;
+        size_t reso = size_t(width) * height;
+        switch (dither) {
+            default:
+                for (size_t i = 0; i < reso; i++) {
+                    Color32 src = pixels[i];
+                    Color32 dst = _colors[findNearestCached(src)];
+                    sqError += double(sqDistance(src, dst));
+                    pixels[i] = dst;
+                }
+                break;
+
+            case DITHER_Ordered: {
+                // Spread the threshold map over roughly half a palette step.
+                int32_t spread = Math::max(int32_t(128.0 / std::cbrt(double(_colors.size()))), 2);
+                for (int32_t y = 0, i = 0; y < height; y++) {
+                    for (int32_t x = 0; x < width; x++, i++) {
+                        Color32 src = pixels[i];
+                        if (src.a == 0) {
+                            pixels[i] = _colors[findNearestCached(src)];
+                            continue;
+                        }
+                        int32_t offset = ((BAYER_4X4[((y & 3) << 2) + (x & 3)] * 2 - 15) * spread) >> 5;
+                        Color32 biased(clampUI8(src.r + offset), clampUI8(src.g + offset), clampUI8(src.b + offset), src.a);
+                        Color32 dst = _colors[findNearestCached(biased)];
+                        sqError += double(sqDistance(src, dst));
+                        pixels[i] = dst;
+                    }
+                }
+                break;
+            }
+
+            case DITHER_FloydSteinberg: {
+                // Two rows of per channel error in 1/16ths, padded by one pixel on both sides.
+                std::vector<int32_t> errors(size_t(width + 2) * 8, 0);
+                int32_t* cur = errors.data();
+                int32_t* next = errors.data() + size_t(width + 2) * 4;
+
+                for (int32_t y = 0; y < height; y++) {
+                    memset(next, 0, size_t(width + 2) * 4 * sizeof(int32_t));
+                    bool reverse = (y & 1) != 0;
+                    int32_t dir = reverse ? -1 : 1;
+
+                    for (int32_t k = 0; k < width; k++) {
+                        int32_t x = reverse ? width - 1 - k : k;
+                        Color32& px = pixels[size_t(y) * width + x];
+                        Color32 src = px;
+
+                        if (src.a == 0) {
+                            px = _colors[findNearestCached(src)];
+                            continue;
+                        }
+
+                        int32_t* err = cur + (x + 1) * 4;
+                        Color32 biased(
+                            clampUI8(src.r + (err[0] >> 4)),
+                            clampUI8(src.g + (err[1] >> 4)),
+                            clampUI8(src.b + (err[2] >> 4)),
+                            clampUI8(src.a + (err[3] >> 4)));
+                        if (biased.a == 0) { biased.a = 1; }
+
+                        Color32 dst = _colors[findNearestCached(biased)];
+                        sqError += double(sqDistance(src, dst));
+                        px = dst;
+
+                        int32_t diff[4]{
+                            int32_t(biased.r) - dst.r,
+                            int32_t(biased.g) - dst.g,
+                            int32_t(biased.b) - dst.b,
+                            int32_t(biased.a) - dst.a,
+                        };
+
+                        int32_t* fwd = cur + (x + 1 + dir) * 4;
+                        int32_t* below = next + (x + 1) * 4;
+                        int32_t* belowFwd = next + (x + 1 + dir) * 4;
+                        int32_t* belowBack = next + (x + 1 - dir) * 4;
+                        for (int32_t c = 0; c < 4; c++) {
+                            fwd[c] += diff[c] * 7;
+                            belowBack[c] += diff[c] * 3;
+                            below[c] += diff[c] * 5;
+                            belowFwd[c] += diff[c];
+                        }
+                    }
+                    std::swap(cur, next);
+                }
+                break;
+            }
+        }
+
+        if (stats) {
+            stats->sqError += sqError;
+            stats->samples += uint64_t(reso) * 4;
+        }
+    }
+}
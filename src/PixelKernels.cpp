@@ -0,0 +1,296 @@
+#include <PixelKernels.h>
+#include <cstring>
+#include <smmintrin.h>
+using namespace JCore;
+
+namespace Projections {
+    namespace Kernels {
+        void clipRGBA32(const Color32* src, Color32* dst, size_t count, uint8_t alphaClip) {
+            if (alphaClip < 1) {
+                if (src != dst) {
+                    memcpy(dst, src, count * sizeof(Color32));
+                }
+                return;
+            }
+
+            const __m128i clip = _mm_set1_epi32(alphaClip);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                __m128i cut = _mm_cmplt_epi32(_mm_srli_epi32(px, 24), clip);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_andnot_si128(cut, px));
+            }
+
+            for (; i < count; i++) {
+                uint32_t px = reinterpret_cast<const uint32_t&>(src[i]);
+                reinterpret_cast<uint32_t&>(dst[i]) = (px >> 24) < alphaClip ? 0 : px;
+            }
+        }
+
+        void expandRGB24(const uint8_t* src, Color32* dst, size_t count) {
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32(int32_t(0xFF000000U));
+
+            // Each step reads 16 bytes but only consumes 12, stop early enough to stay in bounds.
+            size_t i = 0;
+            for (; i + 6 <= count; i += 4, src += 12) {
+                __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+            }
+
+            for (; i < count; i++, src += 3) {
+                dst[i] = Color32(src[0], src[1], src[2], 0xFF);
+            }
+        }
+
+        void expandBGR24(const uint8_t* src, Color32* dst, size_t count) {
+            const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+            const __m128i alpha = _mm_set1_epi32(int32_t(0xFF000000U));
+
+            size_t i = 0;
+            for (; i + 6 <= count; i += 4, src += 12) {
+                __m128i bgr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha));
+            }
+
+            for (; i < count; i++, src += 3) {
+                dst[i] = Color32(src[2], src[1], src[0], 0xFF);
+            }
+        }
+
+        void swizzleBGRA32(const uint8_t* src, Color32* dst, size_t count, bool opaque) {
+            const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            const __m128i alpha = _mm_set1_epi32(opaque ? int32_t(0xFF000000U) : 0);
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4, src += 16) {
+                __m128i bgra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_shuffle_epi8(bgra, shuffle), alpha));
+            }
+
+            for (; i < count; i++, src += 4) {
+                dst[i] = Color32(src[2], src[1], src[0], opaque ? 0xFF : src[3]);
+            }
+        }
+
+        void expandIndexed8(const uint8_t* src, const Color32* lut, Color32* dst, size_t count, uint8_t alphaClip) {
+            uint32_t clipped[256];
+            clipRGBA32(lut, reinterpret_cast<Color32*>(clipped), 256, alphaClip);
+
+            uint32_t* out = reinterpret_cast<uint32_t*>(dst);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                out[i + 0] = clipped[src[i + 0]];
+                out[i + 1] = clipped[src[i + 1]];
+                out[i + 2] = clipped[src[i + 2]];
+                out[i + 3] = clipped[src[i + 3]];
+            }
+
+            for (; i < count; i++) {
+                out[i] = clipped[src[i]];
+            }
+        }
+
+        static inline __m128i premultiplyHalf(__m128i px) {
+            // Two pixels as 16-bit lanes, broadcast each pixel's alpha across its own four lanes.
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), _mm_set1_epi16(128));
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+
+        void premultiplyRGBA32(Color32* data, size_t count) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i alphaMask = _mm_set1_epi32(int32_t(0xFF000000U));
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m128i* ptr = reinterpret_cast<__m128i*>(data + i);
+                __m128i px = _mm_loadu_si128(ptr);
+                __m128i lo = premultiplyHalf(_mm_unpacklo_epi8(px, zero));
+                __m128i hi = premultiplyHalf(_mm_unpackhi_epi8(px, zero));
+                __m128i rgb = _mm_andnot_si128(alphaMask, _mm_packus_epi16(lo, hi));
+                _mm_storeu_si128(ptr, _mm_or_si128(rgb, _mm_and_si128(px, alphaMask)));
+            }
+
+            for (; i < count; i++) {
+                Color32& c = data[i];
+                c.r = mulDiv255(c.r, c.a);
+                c.g = mulDiv255(c.g, c.a);
+                c.b = mulDiv255(c.b, c.a);
+            }
+        }
+
+        bool isZero(const Color32* data, size_t count) {
+            const __m128i* ptr = reinterpret_cast<const __m128i*>(data);
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16, ptr += 4) {
+                __m128i acc = _mm_or_si128(
+                    _mm_or_si128(_mm_loadu_si128(ptr + 0), _mm_loadu_si128(ptr + 1)),
+                    _mm_or_si128(_mm_loadu_si128(ptr + 2), _mm_loadu_si128(ptr + 3)));
+                if (!_mm_testz_si128(acc, acc)) { return false; }
+            }
+
+            const uint32_t* values = reinterpret_cast<const uint32_t*>(data);
+            for (; i < count; i++) {
+                if (values[i] != 0) { return false; }
+            }
+            return true;
+        }
+
+        void rangeUI16(const uint16_t* src, size_t count, uint16_t& lowest, uint16_t& highest) {
+            uint16_t lo = src[0];
+            uint16_t hi = src[0];
+
+            size_t i = 0;
+            if (count >= 8) {
+                __m128i vMin = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i vMax = vMin;
+                for (i = 8; i + 8 <= count; i += 8) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                    vMin = _mm_min_epu16(vMin, v);
+                    vMax = _mm_max_epu16(vMax, v);
+                }
+
+                // 'minpos' only finds minimums, the maximum is found as the minimum of the complement.
+                lo = uint16_t(_mm_cvtsi128_si32(_mm_minpos_epu16(vMin)));
+                hi = uint16_t(~_mm_cvtsi128_si32(_mm_minpos_epu16(_mm_xor_si128(vMax, _mm_set1_epi32(-1)))));
+            }
+
+            for (; i < count; i++) {
+                lo = src[i] < lo ? src[i] : lo;
+                hi = src[i] > hi ? src[i] : hi;
+            }
+            lowest = lo;
+            highest = hi;
+        }
+
+        void narrowUI16(const uint16_t* src, uint8_t* dst, size_t count, uint16_t offset) {
+            const __m128i vOffset = _mm_set1_epi16(int16_t(offset));
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m128i lo = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), vOffset);
+                __m128i hi = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), vOffset);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+            }
+
+            for (; i < count; i++) {
+                dst[i] = uint8_t(src[i] - offset);
+            }
+        }
+
+        void widenUI8(const uint8_t* src, uint16_t* dst, size_t count) {
+            const __m128i zero = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(v, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+            }
+
+            for (; i < count; i++) {
+                dst[i] = src[i];
+            }
+        }
+
+        template<uint8_t MASK>
+        static inline uint32_t reduceScalar(uint32_t px) {
+            uint32_t r = px & 0xFF;
+            uint32_t g = (px >> 8) & 0xFF;
+            uint32_t b = (px >> 16) & 0xFF;
+            uint32_t a = px >> 24;
+
+            uint32_t value = 0;
+            switch (MASK & (UI8_Red | UI8_Green | UI8_Blue)) {
+                case UI8_Red | UI8_Green | UI8_Blue: value = (19595 * r + 38470 * g + 7471 * b) >> 16; break;
+                case UI8_Red:   value = r; break;
+                case UI8_Green: value = g; break;
+                case UI8_Blue:  value = b; break;
+                case UI8_Red | UI8_Green: value = (r + (g >> 1)) & 0xFF; break;
+                case UI8_Green | UI8_Blue: value = (g + (b >> 1)) & 0xFF; break;
+                case UI8_Red | UI8_Blue: value = (r + (b >> 1)) & 0xFF; break;
+            }
+
+            if (MASK == UI8_Alpha) {
+                return a;
+            }
+            if (MASK & UI8_Alpha) {
+                return mulDiv255(value, a);
+            }
+            return value;
+        }
+
+        template<uint8_t MASK>
+        static inline __m128i reduceSimd(__m128i px) {
+            const __m128i lo = _mm_set1_epi32(0xFF);
+            __m128i r = _mm_and_si128(px, lo);
+            __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), lo);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), lo);
+            __m128i a = _mm_srli_epi32(px, 24);
+
+            __m128i value = _mm_setzero_si128();
+            switch (MASK & (UI8_Red | UI8_Green | UI8_Blue)) {
+                case UI8_Red | UI8_Green | UI8_Blue:
+                    value = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(
+                        _mm_mullo_epi32(r, _mm_set1_epi32(19595)),
+                        _mm_mullo_epi32(g, _mm_set1_epi32(38470))),
+                        _mm_mullo_epi32(b, _mm_set1_epi32(7471))), 16);
+                    break;
+                case UI8_Red:   value = r; break;
+                case UI8_Green: value = g; break;
+                case UI8_Blue:  value = b; break;
+                case UI8_Red | UI8_Green: value = _mm_and_si128(_mm_add_epi32(r, _mm_srli_epi32(g, 1)), lo); break;
+                case UI8_Green | UI8_Blue: value = _mm_and_si128(_mm_add_epi32(g, _mm_srli_epi32(b, 1)), lo); break;
+                case UI8_Red | UI8_Blue: value = _mm_and_si128(_mm_add_epi32(r, _mm_srli_epi32(b, 1)), lo); break;
+            }
+
+            if (MASK == UI8_Alpha) {
+                return a;
+            }
+            if (MASK & UI8_Alpha) {
+                __m128i t = _mm_add_epi32(_mm_mullo_epi32(value, a), _mm_set1_epi32(128));
+                return _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+            }
+            return value;
+        }
+
+        template<uint8_t MASK>
+        static void reduceKernel(const Color32* src, uint8_t* dst, size_t count) {
+            const __m128i* data = reinterpret_cast<const __m128i*>(src);
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16, data += 4) {
+                __m128i v0 = reduceSimd<MASK>(_mm_loadu_si128(data + 0));
+                __m128i v1 = reduceSimd<MASK>(_mm_loadu_si128(data + 1));
+                __m128i v2 = reduceSimd<MASK>(_mm_loadu_si128(data + 2));
+                __m128i v3 = reduceSimd<MASK>(_mm_loadu_si128(data + 3));
+                __m128i packed = _mm_packus_epi16(_mm_packus_epi32(v0, v1), _mm_packus_epi32(v2, v3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+            }
+
+            const uint32_t* values = reinterpret_cast<const uint32_t*>(src);
+            for (; i < count; i++) {
+                dst[i] = uint8_t(reduceScalar<MASK>(values[i]));
+            }
+        }
+
+        void reduceToUI8(const Color32* src, uint8_t* dst, size_t count, uint8_t colorMask) {
+            switch (colorMask & 0xF) {
+                case 0x0: reduceKernel<0x0>(src, dst, count); break;
+                case 0x1: reduceKernel<0x1>(src, dst, count); break;
+                case 0x2: reduceKernel<0x2>(src, dst, count); break;
+                case 0x3: reduceKernel<0x3>(src, dst, count); break;
+                case 0x4: reduceKernel<0x4>(src, dst, count); break;
+                case 0x5: reduceKernel<0x5>(src, dst, count); break;
+                case 0x6: reduceKernel<0x6>(src, dst, count); break;
+                case 0x7: reduceKernel<0x7>(src, dst, count); break;
+                case 0x8: reduceKernel<0x8>(src, dst, count); break;
+                case 0x9: reduceKernel<0x9>(src, dst, count); break;
+                case 0xA: reduceKernel<0xA>(src, dst, count); break;
+                case 0xB: reduceKernel<0xB>(src, dst, count); break;
+                case 0xC: reduceKernel<0xC>(src, dst, count); break;
+                case 0xD: reduceKernel<0xD>(src, dst, count); break;
+                case 0xE: reduceKernel<0xE>(src, dst, count); break;
+                case 0xF: reduceKernel<0xF>(src, dst, count); break;
+            }
+        }
+    }
+}
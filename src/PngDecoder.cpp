@@ -0,0 +1,561 @@
+#include <PngDecoder.h>
+#include <PixelKernels.h>
+#include <cstring>
+#include <vector>
+#include <smmintrin.h>
+using namespace JCore;
+
+namespace Projections {
+    namespace PngDecoder {
+        // Limits what we take on ourselves, anything larger is left to J-Core.
+        static constexpr uint32_t MAX_DIMENSION = 1U << 16;
+        static constexpr size_t MAX_PIXELS = size_t(1) << 28;
+
+        // Room for 8 byte match copies to run past the end of the output.
+        static constexpr size_t COPY_SLACK = 8;
+
+        static inline uint32_t readBE32(const uint8_t* data) {
+            return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+        }
+
+        static inline uint32_t reverseBits(uint32_t value, uint32_t bits) {
+            value = ((value & 0xAAAA) >> 1) | ((value & 0x5555) << 1);
+            value = ((value & 0xCCCC) >> 2) | ((value & 0x3333) << 2);
+            value = ((value & 0xF0F0) >> 4) | ((value & 0x0F0F) << 4);
+            value = ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
+            return value >> (16 - bits);
+        }
+
+        // LSB first bit buffer refilled 8 bytes at a time, reading past the end
+        // yields zeroes which are counted so overruns can be detected afterwards.
+        struct BitReader {
+            const uint8_t* pos{};
+            const uint8_t* end{};
+            uint64_t bits{};
+            uint32_t count{};
+            uint32_t padded{};
+
+            void refill() {
+                if (size_t(end - pos) >= sizeof(uint64_t)) {
+                    uint64_t value;
+                    memcpy(&value, pos, sizeof(uint64_t));
+                    bits |= value << count;
+                    pos += (63 - count) >> 3;
+                    count |= 56;
+                    return;
+                }
+
+                while (count <= 56) {
+                    uint64_t value = 0;
+                    if (pos < end) {
+                        value = *pos++;
+                    }
+                    else {
+                        padded++;
+                    }
+                    bits |= value << count;
+                    count += 8;
+                }
+            }
+
+            uint32_t getBits(uint32_t n) {
+                if (count < n) { refill(); }
+                uint32_t value = uint32_t(bits & ((uint64_t(1) << n) - 1));
+                bits >>= n;
+                count -= n;
+                return value;
+            }
+
+            bool isOverrun() const {
+                return size_t(padded) * 8 > count;
+            }
+        };
+
+        struct Huffman {
+            static constexpr uint32_t FAST_BITS = 10;
+            static constexpr uint32_t FAST_MASK = (1U << FAST_BITS) - 1;
+            static constexpr uint32_t MAX_SYMBOLS = 288;
+
+            // (length << 9) | symbol for codes of up to FAST_BITS, 0 for longer codes.
+            uint16_t fast[1U << FAST_BITS];
+            uint16_t firstCode[16];
+            uint32_t maxCode[17];
+            uint16_t firstSymbol[16];
+            uint8_t size[MAX_SYMBOLS];
+            uint16_t value[MAX_SYMBOLS];
+
+            bool build(const uint8_t* lengths, uint32_t count) {
+                uint32_t sizes[17]{ 0 };
+                uint32_t nextCode[16]{ 0 };
+                memset(fast, 0, sizeof(fast));
+
+                for (uint32_t i = 0; i < count; i++) {
+                    sizes[lengths[i]]++;
+                }
+                sizes[0] = 0;
+
+                uint32_t code = 0;
+                uint32_t symbols = 0;
+                for (uint32_t i = 1; i < 16; i++) {
+                    if (sizes[i] > (1U << i)) { return false; }
+                    nextCode[i] = code;
+                    firstCode[i] = uint16_t(code);
+                    firstSymbol[i] = uint16_t(symbols);
+                    code += sizes[i];
+                    if (sizes[i] > 0 && code - 1 >= (1U << i)) { return false; }
+                    maxCode[i] = code << (16 - i);
+                    code <<= 1;
+                    symbols += sizes[i];
+                }
+                maxCode[16] = 0x10000;
+
+                for (uint32_t i = 0; i < count; i++) {
+                    uint32_t len = lengths[i];
+                    if (len == 0) { continue; }
+
+                    uint32_t slot = nextCode[len] - firstCode[len] + firstSymbol[len];
+                    size[slot] = uint8_t(len);
+                    value[slot] = uint16_t(i);
+                    if (len <= FAST_BITS) {
+                        for (uint32_t j = reverseBits(nextCode[len], len); j < (1U << FAST_BITS); j += (1U << len)) {
+                            fast[j] = uint16_t((len << 9) | i);
+                        }
+                    }
+                    nextCode[len]++;
+                }
+                return true;
+            }
+
+            int32_t decode(BitReader& reader) const {
+                if (reader.count < 16) { reader.refill(); }
+
+                uint32_t entry = fast[reader.bits & FAST_MASK];
+                if (entry) {
+                    uint32_t len = entry >> 9;
+                    reader.bits >>= len;
+                    reader.count -= len;
+                    return int32_t(entry & 0x1FF);
+                }
+
+                uint32_t code = reverseBits(uint32_t(reader.bits & 0xFFFF), 16);
+                uint32_t len = FAST_BITS + 1;
+                while (len < 16 && code >= maxCode[len]) { len++; }
+                if (len >= 16) { return -1; }
+
+                uint32_t slot = (code >> (16 - len)) - firstCode[len] + firstSymbol[len];
+                if (slot >= MAX_SYMBOLS || size[slot] != len) { return -1; }
+
+                reader.bits >>= len;
+                reader.count -= len;
+                return int32_t(value[slot]);
+            }
+        };
+
+        static constexpr uint16_t LENGTH_BASE[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static constexpr uint8_t LENGTH_EXTRA[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static constexpr uint16_t DIST_BASE[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static constexpr uint8_t DIST_EXTRA[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        struct FixedTables {
+            Huffman lit;
+            Huffman dist;
+
+            FixedTables() {
+                uint8_t lengths[Huffman::MAX_SYMBOLS];
+                memset(lengths + 0, 8, 144);
+                memset(lengths + 144, 9, 112);
+                memset(lengths + 256, 7, 24);
+                memset(lengths + 280, 8, 8);
+                lit.build(lengths, 288);
+
+                memset(lengths, 5, 30);
+                dist.build(lengths, 30);
+            }
+        };
+
+        struct Inflater {
+            BitReader reader{};
+            uint8_t* start{};
+            uint8_t* out{};
+            uint8_t* end{};
+            Huffman lit;
+            Huffman dist;
+
+            bool readDynamic() {
+                static constexpr uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+                uint32_t hlit = reader.getBits(5) + 257;
+                uint32_t hdist = reader.getBits(5) + 1;
+                uint32_t hclen = reader.getBits(4) + 4;
+
+                uint8_t codeLengths[19]{ 0 };
+                for (uint32_t i = 0; i < hclen; i++) {
+                    codeLengths[ORDER[i]] = uint8_t(reader.getBits(3));
+                }
+
+                Huffman lengthCodes;
+                if (!lengthCodes.build(codeLengths, 19)) { return false; }
+
+                uint8_t lengths[Huffman::MAX_SYMBOLS + 32]{ 0 };
+                uint32_t total = hlit + hdist;
+                uint32_t n = 0;
+                while (n < total) {
+                    int32_t sym = lengthCodes.decode(reader);
+                    if (sym < 0 || sym >= 19 || reader.padded > 8) { return false; }
+
+                    if (sym < 16) {
+                        lengths[n++] = uint8_t(sym);
+                        continue;
+                    }
+
+                    uint8_t fill = 0;
+                    uint32_t repeat = 0;
+                    switch (sym) {
+                        case 16:
+                            if (n == 0) { return false; }
+                            fill = lengths[n - 1];
+                            repeat = reader.getBits(2) + 3;
+                            break;
+                        case 17: repeat = reader.getBits(3) + 3; break;
+                        default: repeat = reader.getBits(7) + 11; break;
+                    }
+                    if (n + repeat > total) { return false; }
+                    memset(lengths + n, fill, repeat);
+                    n += repeat;
+                }
+
+                if (lengths[256] == 0) { return false; }
+                return lit.build(lengths, hlit) && dist.build(lengths + hlit, hdist);
+            }
+
+            bool readStored() {
+                reader.getBits(reader.count & 7);
+                uint32_t len = reader.getBits(16);
+                uint32_t nlen = reader.getBits(16);
+                if ((len ^ 0xFFFF) != nlen) { return false; }
+
+                // Drain whatever is still buffered before copying straight from the input.
+                while (len > 0 && reader.count >= 8) {
+                    if (out >= end) { return false; }
+                    *out++ = uint8_t(reader.getBits(8));
+                    len--;
+                }
+
+                if (len > 0) {
+                    reader.bits = 0;
+                    if (size_t(reader.end - reader.pos) < len || size_t(end - out) < len) { return false; }
+                    memcpy(out, reader.pos, len);
+                    reader.pos += len;
+                    out += len;
+                }
+                return true;
+            }
+
+            bool readCompressed(const Huffman& litCodes, const Huffman& distCodes) {
+                for (;;) {
+                    int32_t sym = litCodes.decode(reader);
+                    if (sym < 0 || reader.padded > 8) { return false; }
+
+                    if (sym < 256) {
+                        if (out >= end) { return false; }
+                        *out++ = uint8_t(sym);
+                        continue;
+                    }
+                    if (sym == 256) { return true; }
+
+                    sym -= 257;
+                    if (sym >= 29) { return false; }
+                    size_t len = LENGTH_BASE[sym] + reader.getBits(LENGTH_EXTRA[sym]);
+
+                    int32_t dsym = distCodes.decode(reader);
+                    if (dsym < 0 || dsym >= 30) { return false; }
+                    size_t distance = DIST_BASE[dsym] + reader.getBits(DIST_EXTRA[dsym]);
+
+                    if (distance > size_t(out - start) || len > size_t(end - out)) { return false; }
+
+                    const uint8_t* src = out - distance;
+                    if (distance >= 8) {
+                        // May write up to 7 bytes past 'out + len', covered by COPY_SLACK.
+                        uint8_t* dst = out;
+                        uint8_t* target = out + len;
+                        while (dst < target) {
+                            memcpy(dst, src, 8);
+                            dst += 8;
+                            src += 8;
+                        }
+                    }
+                    else if (distance == 1) {
+                        memset(out, *src, len);
+                    }
+                    else {
+                        for (size_t i = 0; i < len; i++) {
+                            out[i] = src[i];
+                        }
+                    }
+                    out += len;
+                }
+            }
+
+            bool inflate(const uint8_t* data, size_t size, uint8_t* dst, size_t dstSize) {
+                static const FixedTables fixed{};
+
+                // zlib header: deflate, window of at most 32 KB, valid check bits and no preset dictionary.
+                if (size < 2) { return false; }
+                uint32_t cmf = data[0];
+                uint32_t flg = data[1];
+                if ((cmf & 0xF) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) { return false; }
+
+                reader = BitReader{ data + 2, data + size };
+                start = out = dst;
+                end = dst + dstSize;
+
+                uint32_t isFinal = 0;
+                while (!isFinal) {
+                    isFinal = reader.getBits(1);
+                    bool valid = false;
+                    switch (reader.getBits(2)) {
+                        case 0: valid = readStored(); break;
+                        case 1: valid = readCompressed(fixed.lit, fixed.dist); break;
+                        case 2: valid = readDynamic() && readCompressed(lit, dist); break;
+                        default: break;
+                    }
+                    if (!valid || reader.isOverrun()) { return false; }
+                }
+                return out == end;
+            }
+        };
+
+        template<size_t BPP>
+        static inline __m128i loadPixel(const uint8_t* data) {
+            int32_t value = 0;
+            memcpy(&value, data, BPP);
+            return _mm_cvtsi32_si128(value);
+        }
+
+        template<size_t BPP>
+        static inline void storePixel(uint8_t* data, __m128i value) {
+            int32_t pixel = _mm_cvtsi128_si32(value);
+            memcpy(data, &pixel, BPP);
+        }
+
+        // Sub, Avg and Paeth depend on the pixel to the left so they go one pixel per step,
+        // Up has no such dependency and goes 16 bytes per step.
+        // 'src' and 'dst' may be the same row, 'prev' is the reconstructed row above.
+        template<size_t BPP>
+        static bool unfilterRow(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes) {
+            switch (filter) {
+                case 0:
+                    if (src != dst) {
+                        memcpy(dst, src, rowBytes);
+                    }
+                    return true;
+                case 1: {
+                    __m128i a = _mm_setzero_si128();
+                    for (size_t i = 0; i < rowBytes; i += BPP) {
+                        a = _mm_add_epi8(a, loadPixel<BPP>(src + i));
+                        storePixel<BPP>(dst + i, a);
+                    }
+                    return true;
+                }
+                case 2: {
+                    size_t i = 0;
+                    for (; i + 16 <= rowBytes; i += 16) {
+                        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(x, b));
+                    }
+                    for (; i < rowBytes; i++) {
+                        dst[i] = uint8_t(src[i] + prev[i]);
+                    }
+                    return true;
+                }
+                case 3: {
+                    // 'avg' rounds up, subtracting the dropped low bit makes it floor((a + b) / 2).
+                    const __m128i one = _mm_set1_epi8(1);
+                    __m128i a = _mm_setzero_si128();
+                    for (size_t i = 0; i < rowBytes; i += BPP) {
+                        __m128i b = loadPixel<BPP>(prev + i);
+                        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+                        a = _mm_add_epi8(loadPixel<BPP>(src + i), avg);
+                        storePixel<BPP>(dst + i, a);
+                    }
+                    return true;
+                }
+                case 4: {
+                    // Paeth in 16-bit lanes, p - a = b - c and p - b = a - c.
+                    const __m128i zero = _mm_setzero_si128();
+                    __m128i a = zero;
+                    __m128i c = zero;
+                    for (size_t i = 0; i < rowBytes; i += BPP) {
+                        __m128i b = _mm_unpacklo_epi8(loadPixel<BPP>(prev + i), zero);
+                        __m128i x = _mm_unpacklo_epi8(loadPixel<BPP>(src + i), zero);
+
+                        __m128i pa = _mm_sub_epi16(b, c);
+                        __m128i pb = _mm_sub_epi16(a, c);
+                        __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+                        pa = _mm_abs_epi16(pa);
+                        pb = _mm_abs_epi16(pb);
+
+                        __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                        __m128i nearest = _mm_blendv_epi8(
+                            _mm_blendv_epi8(c, b, _mm_cmpeq_epi16(smallest, pb)),
+                            a, _mm_cmpeq_epi16(smallest, pa));
+
+                        a = _mm_and_si128(_mm_add_epi16(x, nearest), _mm_set1_epi16(0xFF));
+                        c = b;
+                        storePixel<BPP>(dst + i, _mm_packus_epi16(a, a));
+                    }
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        static constexpr uint8_t COLOR_RGB = 2;
+        static constexpr uint8_t COLOR_RGBA = 6;
+
+        struct Header {
+            uint32_t width{};
+            uint32_t height{};
+            uint8_t colorType{};
+        };
+
+        static bool readHeader(const uint8_t* data, size_t size, Header& header) {
+            static constexpr uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            if (size < HEADER_SIZE || memcmp(data, SIGNATURE, 8) != 0) { return false; }
+
+            // IHDR has to come first.
+            const uint8_t* ihdr = data + 8;
+            if (readBE32(ihdr) != 13 || memcmp(ihdr + 4, "IHDR", 4) != 0) { return false; }
+
+            header.width = readBE32(ihdr + 8);
+            header.height = readBE32(ihdr + 12);
+            header.colorType = ihdr[17];
+            uint8_t bitDepth = ihdr[16];
+            if (header.width < 1 || header.height < 1 || header.width > MAX_DIMENSION || header.height > MAX_DIMENSION ||
+                size_t(header.width) * header.height > MAX_PIXELS) {
+                return false;
+            }
+            if (bitDepth != 8 || (header.colorType != COLOR_RGB && header.colorType != COLOR_RGBA)) { return false; }
+            return ihdr[18] == 0 && ihdr[19] == 0 && ihdr[20] == 0;
+        }
+
+        bool getInfo(const uint8_t* data, size_t size, ImageData& img) {
+            Header header{};
+            if (!readHeader(data, size, header)) { return false; }
+
+            img.width = int32_t(header.width);
+            img.height = int32_t(header.height);
+            img.format = header.colorType == COLOR_RGBA ? TextureFormat::RGBA32 : TextureFormat::RGB24;
+            return true;
+        }
+
+        bool decode(const uint8_t* data, size_t size, ImageData& img) {
+            Header header{};
+            if (!readHeader(data, size, header)) { return false; }
+
+            const uint8_t* ihdr = data + 8;
+            const uint32_t width = header.width;
+            const uint32_t height = header.height;
+            const uint8_t colorType = header.colorType;
+
+            thread_local std::vector<uint8_t> idatBuffer{};
+            thread_local std::vector<uint8_t> rawBuffer{};
+
+            // Most files have a single IDAT which is inflated straight from the input.
+            const uint8_t* idat = nullptr;
+            size_t idatSize = 0;
+            size_t idatCount = 0;
+            idatBuffer.clear();
+
+            const uint8_t* pos = ihdr + 25;
+            const uint8_t* end = data + size;
+            bool hasEnd = false;
+            while (!hasEnd) {
+                if (size_t(end - pos) < 12) { return false; }
+                uint32_t length = readBE32(pos);
+                const uint8_t* type = pos + 4;
+                const uint8_t* chunk = pos + 8;
+                if (length > size_t(end - chunk) - 4) { return false; }
+
+                if (memcmp(type, "IDAT", 4) == 0) {
+                    if (idatCount == 1) {
+                        idatBuffer.assign(idat, idat + idatSize);
+                    }
+                    if (idatCount > 0) {
+                        idatBuffer.insert(idatBuffer.end(), chunk, chunk + length);
+                    }
+                    else {
+                        idat = chunk;
+                        idatSize = length;
+                    }
+                    idatCount++;
+                }
+                else if (memcmp(type, "IEND", 4) == 0) {
+                    hasEnd = true;
+                }
+                else if (memcmp(type, "tRNS", 4) == 0) {
+                    // Color keyed transparency is rare enough to leave to J-Core.
+                    return false;
+                }
+                pos = chunk + length + 4;
+            }
+
+            if (idatCount == 0) { return false; }
+            if (idatCount > 1) {
+                idat = idatBuffer.data();
+                idatSize = idatBuffer.size();
+            }
+
+            const size_t bpp = colorType == COLOR_RGBA ? 4 : 3;
+            const size_t rowBytes = size_t(width) * bpp;
+            const size_t stride = rowBytes + 1;
+            const size_t rawSize = stride * height;
+            if (rawBuffer.size() < rawSize + COPY_SLACK) {
+                rawBuffer.resize(rawSize + COPY_SLACK);
+            }
+
+            Inflater inflater;
+            if (!inflater.inflate(idat, idatSize, rawBuffer.data(), rawSize)) { return false; }
+
+            if (!img.doAllocate(int32_t(width), int32_t(height), TextureFormat::RGBA32)) { return false; }
+
+            thread_local std::vector<uint8_t> zeroRow{};
+            if (zeroRow.size() < rowBytes) {
+                zeroRow.resize(rowBytes, 0);
+            }
+
+            // RGBA rows are reconstructed straight into the image, RGB rows are
+            // reconstructed in place and then expanded.
+            uint8_t* raw = rawBuffer.data();
+            uint8_t* pixels = img.data;
+            const size_t outStride = size_t(width) * sizeof(Color32);
+            for (size_t y = 0; y < height; y++) {
+                const uint8_t* src = raw + y * stride;
+                bool valid = false;
+                if (bpp == 4) {
+                    const uint8_t* prev = y > 0 ? pixels + (y - 1) * outStride : zeroRow.data();
+                    valid = unfilterRow<4>(src[0], src + 1, prev, pixels + y * outStride, rowBytes);
+                }
+                else {
+                    uint8_t* row = raw + y * stride + 1;
+                    const uint8_t* prev = y > 0 ? row - stride : zeroRow.data();
+                    valid = unfilterRow<3>(src[0], row, prev, row, rowBytes);
+                    Kernels::expandRGB24(row, reinterpret_cast<Color32*>(pixels + y * outStride), width);
+                }
+
+                if (!valid) { return false; }
+            }
+            return true;
+        }
+    }
+}
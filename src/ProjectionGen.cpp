@@ -1,5 +1,8 @@
 #include <ProjectionGen.h>
+#include <ParallelUtils.h>
+#include <PixelKernels.h>
 #include <algorithm>
+#include <chrono>
 #include <J-Core/IO/FileStream.h>
 #include <J-Core/Log.h>
 #include <J-Core/IO/Image.h>
@@ -11,13 +14,6 @@
 using namespace JCore;
 
 namespace Projections {
-    enum UI8Mode {
-        UI8_Red = 0x01,
-        UI8_Green = 0x02,
-        UI8_Blue = 0x04,
-        UI8_Alpha = 0x08,
-    };
-
     template<typename T, uint32_t MAX_RUN>
     static uint32_t getRunLength_Long(size_t pos, const T* data, size_t length) {
         uint32_t runLen = 1;
@@ -32,8 +28,31 @@ namespace Projections {
         return runLen;
     }
 
-    template<typename T>
-    static int32_t applyRLE_Normal(const Stream& stream, int32_t resolution, const T* pixels) {
+    // Minimal stream over a byte vector, lets the frame encoders build blobs in memory.
+    struct BlobWriter {
+        std::vector<uint8_t>& data;
+
+        void write(const void* ptr, size_t size, bool) const {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ptr);
+            data.insert(data.end(), bytes, bytes + size);
+        }
+
+        template<typename T>
+        void writeValue(const T& value, size_t count = 1, bool bigEndian = false) const {
+            write(&value, sizeof(T) * count, bigEndian);
+        }
+    };
+
+    // Stream that drops everything, sizes an encoding without writing it.
+    struct NullWriter {
+        void write(const void*, size_t, bool) const {}
+
+        template<typename T>
+        void writeValue(const T&, size_t = 1, bool = false) const {}
+    };
+
+    template<typename T, typename S>
+    static int32_t applyRLE_Normal(const S& stream, int32_t resolution, const T* pixels) {
         int32_t bytesWritten = 0;
 
         int32_t pos = 0;
@@ -54,81 +73,89 @@ namespace Projections {
                 hdr |= 0x1;
             }
             bytesWritten += (size_t(hdr & 0x3) + 1 + sizeof(T));
-            pos += runLen;
 
             stream.write(&hdr, size_t(hdr & 0x3) + 1, false);
             stream.writeValue(pixels[pos], 1, false);
+            pos += runLen;
         }
         return bytesWritten;
     }
 
-    static void readAsColor32(const ImageData& src, Color32* pixels, uint8_t alphaClip) {
-        int32_t pixC = src.width * src.height;
-        if (src.format == TextureFormat::RGBA32) {
-            memcpy(pixels, src.data, pixC * sizeof(Color32));
-            if (alphaClip > 0) {
-                for (int32_t i = 0; i < pixC; i++) {
-                    if (pixels[i].a < alphaClip) {
-                        reinterpret_cast<uint32_t&>(pixels[i]) = 0;
-                    }
+    // Share of a payload RLE saves, a palette table written in front counts towards both sizes.
+    static float getCompressionRatio(size_t rleSize, size_t rawSize, size_t tableSize = 0) {
+        return 1.0f - float(rleSize + tableSize) / float(rawSize + tableSize);
+    }
+
+    // Bytes a payload takes once written, RLE is only kept when it saves at least 'minCompression'.
+    static size_t getPayloadSize(size_t rleSize, size_t rawSize, size_t tableSize, float minCompression) {
+        return (getCompressionRatio(rleSize, rawSize, tableSize) < minCompression ? rawSize : rleSize) + tableSize;
+    }
+
+    // Converts ranges of an image to clipped RGBA32, the source format is resolved once on construction.
+    struct ColorConverter {
+        const ImageData& src;
+        uint8_t alphaClip{};
+        size_t bpp{};
+        Color32 lut[256]{};
+
+        ColorConverter(const ImageData& src, uint8_t alphaClip) : src(src), alphaClip(alphaClip), bpp(getBitsPerPixel(src.format) >> 3) {
+            if (src.format == TextureFormat::Indexed8) {
+                // Resolve the palette through convertPixel once, then expand with a flat lookup.
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint8_t index = uint8_t(i);
+                    convertPixel(src.format, src.data, &index, lut[i]);
                 }
+                Kernels::clipRGBA32(lut, lut, 256, alphaClip);
             }
-            return;
         }
 
-        const uint8_t* dataPos = src.getData();
-        size_t bpp = getBitsPerPixel(src.format) >> 3;
-        for (int32_t i = 0; i < pixC; i++) {
-            convertPixel(src.format, src.data, dataPos, pixels[i]);
-            if (pixels[i].a < alphaClip) {
-                reinterpret_cast<uint32_t&>(pixels[i]) = 0;
+        void convert(size_t start, size_t count, Color32* pixels) const {
+            switch (src.format) {
+                case TextureFormat::RGBA32:
+                    Kernels::clipRGBA32(reinterpret_cast<const Color32*>(src.getData()) + start, pixels, count, alphaClip);
+                    return;
+                case TextureFormat::RGB24:
+                    Kernels::expandRGB24(src.getData() + start * 3, pixels, count);
+                    return;
+                case TextureFormat::Indexed8:
+                    Kernels::expandIndexed8(src.getData() + start, lut, pixels, count, 0);
+                    return;
+                default:
+                    break;
             }
-            dataPos += bpp;
+
+            const uint8_t* dataPos = src.getData() + start * bpp;
+            for (size_t i = 0; i < count; i++) {
+                convertPixel(src.format, src.data, dataPos, pixels[i]);
+                dataPos += bpp;
+            }
+            Kernels::clipRGBA32(pixels, pixels, count, alphaClip);
         }
+    };
+
+    static void readAsColor32(const ImageData& src, Color32* pixels, uint8_t alphaClip) {
+        ColorConverter(src, alphaClip).convert(0, size_t(src.width) * src.height, pixels);
     }
 
     static void readAsUI8(const ImageData& src, uint8_t* pixels, uint8_t colorMask) {
-        int32_t pixC = src.width * src.height;
+        size_t pixC = size_t(src.width) * src.height;
+        if (src.format == TextureFormat::RGBA32) {
+            Kernels::reduceToUI8(reinterpret_cast<const Color32*>(src.getData()), pixels, pixC, colorMask);
+            return;
+        }
+
+        // Other formats are converted in blocks small enough to stay in L1.
+        static constexpr size_t BLOCK_SIZE = 1024;
+        Color32 block[BLOCK_SIZE];
         const uint8_t* dataPos = src.getData();
-        Color32 temp{};
         size_t bpp = getBitsPerPixel(src.format) >> 3;
-        for (int32_t i = 0; i < pixC; i++) {
-            convertPixel(src.format, src.data, dataPos, temp);
-
-            switch (colorMask & (UI8_Red | UI8_Green | UI8_Blue))
-            {
-                case UI8_Red | UI8_Green | UI8_Blue:
-                    pixels[i] = uint8_t(Math::min(0.299f * temp.r + 0.587f * temp.g + 0.114f * temp.b, 255.0f));
-                    break;
-                case UI8_Red:
-                    pixels[i] = temp.r;
-                    break;
-                case UI8_Green:
-                    pixels[i] = temp.g;
-                    break;
-                case UI8_Blue:
-                    pixels[i] = temp.b;
-                    break;
-
-                case UI8_Red | UI8_Green:
-                    pixels[i] = uint8_t(uint32_t(temp.r) + (temp.g >> 1));
-                    break;
-                case UI8_Green | UI8_Blue:
-                    pixels[i] = uint8_t(uint32_t(temp.g) + (temp.b >> 1));
-                    break;
-                case UI8_Red | UI8_Blue:
-                    pixels[i] = uint8_t(uint32_t(temp.r) + (temp.b >> 1));
-                    break;
-            }
-
-            if (colorMask == UI8_Alpha) {
-                pixels[i] = temp.a;
+        for (size_t i = 0; i < pixC; i += BLOCK_SIZE) {
+            size_t count = Math::min(BLOCK_SIZE, pixC - i);
+            for (size_t j = 0; j < count; j++) {
+                convertPixel(src.format, src.data, dataPos, block[j]);
+                dataPos += bpp;
             }
-            else if ((colorMask & UI8_Alpha) != 0) {
-                pixels[i] = multUI8(pixels[i], temp.a);
-            }
-
-            dataPos += bpp;
+            Kernels::reduceToUI8(block, pixels + i, count, colorMask);
         }
     }
 
@@ -246,7 +273,233 @@ namespace Projections {
         stream.writeValue<uint32_t>(0);
     }
 
-    bool Projection::prepare() {
+    bool PFramePath::readFileBytes(std::string_view root, std::vector<uint8_t>& data) const {
+        if (archive) {
+            return archive->read(entry, data) && data.size() > 0;
+        }
+
+        FileStream fs{};
+        if (!fs.open(IO::combine(root, path), "rb")) { return false; }
+
+        data.resize(fs.size());
+        if (data.size() > 0) {
+            fs.read(data.data(), data.size(), 1);
+        }
+        fs.close();
+        return data.size() > 0;
+    }
+
+    // Reads the first and last PROBE_CHUNK bytes of a file, or all of it if it's no larger than that.
+    static constexpr size_t PROBE_CHUNK = 4096;
+    static bool readFileProbe(const std::string& path, uint64_t size, std::vector<uint8_t>& data) {
+        FileStream fs{};
+        if (!fs.open(path, "rb")) { return false; }
+
+        if (size <= PROBE_CHUNK * 2) {
+            data.resize(size_t(size));
+            fs.read(data.data(), data.size(), 1);
+        }
+        else {
+            data.resize(PROBE_CHUNK * 2);
+            fs.read(data.data(), PROBE_CHUNK, 1);
+            fs.seek(int64_t(size - PROBE_CHUNK), SEEK_SET);
+            fs.read(data.data() + PROBE_CHUNK, PROBE_CHUNK, 1);
+        }
+        fs.close();
+        return true;
+    }
+
+    // Marks sources whose files are byte identical to an earlier slot's, these are written
+    // as pointers to that slot without ever being decoded.
+    // Equal sized sources are told apart by a probe first, the CRC from the ZIP directory for archive
+    // entries and a hash of the file's head and tail otherwise, as equal sized BMP or DDS frames have
+    // equal headers. Only sources whose probes collide are read whole, each of them once.
+    static size_t findAliasedSources(std::vector<PrFrame>& frames, std::string_view root) {
+        auto getPath = [&frames](size_t slot) -> PFramePath& {
+            auto& frame = frames[slot >> 1];
+            return (slot & 0x1) ? frame.pathE : frame.path;
+        };
+
+        size_t slots = frames.size() * 2;
+        std::vector<uint64_t> sizes(slots, 0);
+        std::unordered_map<uint64_t, uint32_t> sizeCounts{};
+        for (size_t i = 0; i < slots; i++) {
+            auto& path = getPath(i);
+            path.aliasOf = PFramePath::NO_ALIAS;
+            if (!path.isValid() || path.isSliced() || path.isStreamed()) { continue; }
+
+            uint64_t size = path.getFileSize(root);
+            if (size < 1) { continue; }
+            sizes[i] = size;
+            sizeCounts[size]++;
+        }
+
+        std::vector<uint32_t> candidates{};
+        for (size_t i = 0; i < slots; i++) {
+            if (sizes[i] > 0 && sizeCounts[sizes[i]] > 1) {
+                candidates.push_back(uint32_t(i));
+            }
+        }
+        if (candidates.size() < 2) { return 0; }
+
+        std::vector<uint64_t> probes(candidates.size(), 0);
+        std::vector<uint8_t> probed(candidates.size(), 0);
+        std::vector<std::vector<uint8_t>> scratch(getWorkerCount());
+        parallelFor(candidates.size(), scratch.size(), [&](size_t i, size_t w) {
+            auto& path = getPath(candidates[i]);
+            if (path.archive) {
+                probes[i] = path.archive->getEntry(path.entry).crc;
+                probed[i] = 1;
+                return;
+            }
+
+            auto& data = scratch[w];
+            if (readFileProbe(IO::combine(root, path.path), sizes[candidates[i]], data)) {
+                FrameHash hash{};
+                hash.from(data.data(), data.size());
+                probes[i] = hash.getKey();
+                probed[i] = 1;
+            }
+            });
+
+        // Sorted by size and probe, ties stay in slot order so every group's first
+        // source of some content is the earliest slot it can be aliased to.
+        std::vector<uint32_t> order{};
+        for (uint32_t i = 0; i < uint32_t(candidates.size()); i++) {
+            if (probed[i]) {
+                order.push_back(i);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+            uint64_t lSize = sizes[candidates[lhs]];
+            uint64_t rSize = sizes[candidates[rhs]];
+            if (lSize != rSize) { return lSize < rSize; }
+            if (probes[lhs] != probes[rhs]) { return probes[lhs] < probes[rhs]; }
+            return lhs < rhs;
+            });
+
+        std::vector<std::pair<size_t, size_t>> groups{};
+        for (size_t i = 0; i < order.size();) {
+            size_t end = i + 1;
+            while (end < order.size() &&
+                sizes[candidates[order[end]]] == sizes[candidates[order[i]]] &&
+                probes[order[end]] == probes[order[i]]) {
+                end++;
+            }
+
+            if (end - i > 1) {
+                groups.emplace_back(i, end);
+            }
+            i = end;
+        }
+        if (groups.size() < 1) { return 0; }
+
+        // Every source of a group is read once and compared against the distinct contents
+        // read before it, those stay in memory only until the group is done.
+        std::vector<size_t> groupAliases(groups.size(), 0);
+        parallelFor(groups.size(), getWorkerCount(), [&](size_t g, size_t) {
+            std::vector<std::vector<uint8_t>> contents{};
+            std::vector<uint32_t> owners{};
+            std::vector<uint8_t> data{};
+
+            for (size_t i = groups[g].first; i < groups[g].second; i++) {
+                uint32_t slot = candidates[order[i]];
+                if (!getPath(slot).readFileBytes(root, data)) { continue; }
+
+                bool found = false;
+                for (size_t j = 0; j < contents.size() && !found; j++) {
+                    if (contents[j] == data) {
+                        getPath(slot).aliasOf = owners[j];
+                        groupAliases[g]++;
+                        found = true;
+                    }
+                }
+
+                if (!found) {
+                    contents.emplace_back(std::move(data));
+                    owners.push_back(slot);
+                    data.clear();
+                }
+            }
+            });
+
+        size_t aliases = 0;
+        for (size_t count : groupAliases) {
+            aliases += count;
+        }
+        return aliases;
+    }
+
+    // Reads the header of every source in parallel and checks that they all share the first source's
+    // resolution, every problem is reported before failing so they can all be fixed in one go.
+    static bool validateSources(std::vector<PrFrame>& frames, std::string_view root, std::string_view nameID, int32_t& width, int32_t& height) {
+        auto getPath = [&frames](size_t slot) -> PFramePath& {
+            auto& frame = frames[slot >> 1];
+            return (slot & 0x1) ? frame.pathE : frame.path;
+        };
+
+        std::vector<uint32_t> slots{};
+        for (size_t i = 0; i < frames.size() * 2; i++) {
+            if (getPath(i).isValid()) {
+                slots.push_back(uint32_t(i));
+            }
+        }
+
+        std::vector<uint8_t> readable(slots.size(), 0);
+        std::vector<ImageData> scratch(getWorkerCount());
+        parallelFor(slots.size(), scratch.size(), [&](size_t i, size_t w) {
+            auto& path = getPath(slots[i]);
+            auto& info = scratch[w];
+            if (path.getInfo(info, root)) {
+                path.width = info.width;
+                path.height = info.height;
+                readable[i] = 1;
+            }
+            });
+        for (auto& info : scratch) {
+            info.clear(true);
+        }
+
+        width = 0;
+        height = 0;
+        size_t unreadable = 0;
+        size_t mismatched = 0;
+        const PFramePath* reference = nullptr;
+        for (size_t i = 0; i < slots.size(); i++) {
+            const auto& path = getPath(slots[i]);
+            if (!readable[i]) {
+                if (path.isArchived()) {
+                    JCORE_ERROR("[{}] Can't read '{}' from '{}', archived frames have to be 8-bit RGB(A) PNGs or uncompressed BMPs or DDSs",
+                        nameID, path.path, path.archive->getPath());
+                }
+                else {
+                    JCORE_ERROR("[{}] Couldn't read the header of '{}'", nameID, path.path);
+                }
+                unreadable++;
+                continue;
+            }
+
+            if (!reference) {
+                reference = &path;
+                width = path.width;
+                height = path.height;
+                continue;
+            }
+
+            if (path.width != width || path.height != height) {
+                JCORE_ERROR("[{}] '{}' is {}x{}, expected {}x{} like '{}'", nameID, path.path, path.width, path.height, width, height, reference->path);
+                mismatched++;
+            }
+        }
+
+        if (unreadable > 0 || mismatched > 0) {
+            JCORE_ERROR("Failed to prepare '{}'! ({} of {} frame sources unreadable, {} with a mismatched resolution)", nameID, unreadable, slots.size(), mismatched);
+            return false;
+        }
+        return true;
+    }
+
+    bool Projection::prepare(const FileIndex* index) {
         std::string path = IO::combine(material.root, framePath);
         if (!IO::exists(path)) {
             JCORE_WARN("Failed to prepare Projection '{0}': Frame path '{1}' doesn't exist!", material.nameID, path);
@@ -260,28 +513,84 @@ namespace Projections {
             "jtex",
         };
 
-        static std::vector<fs::path> paths{};
-        static std::vector<PFramePath> tempPaths{};
-        paths.clear();
-        tempPaths.clear();
+        // Kept local so projections can be prepared concurrently.
+        std::vector<fs::path> paths{};
+        std::vector<const FileIndex::Entry*> indexed{};
+        std::vector<PFramePath> tempPaths{};
 
         float frameDuration = 1.0f / Math::max(frameRate, 0.001f);
-        if (IO::getAll(path, IO::F_TYPE_FILE, paths, true,
-            [](const fs::path& path) {
-                auto ext = IO::getExtension(path);
-                if (ext.length() < 1) { return false; }
-                for (size_t i = 0; i < sizeof(ALLOWED_FILES) / sizeof(std::string_view); i++) {
-                    if (Utils::strIEquals(ext, ALLOWED_FILES[i])) {
-                        return true;
-                    }
+        auto isAllowed = [](const fs::path& path) {
+            auto ext = IO::getExtension(path);
+            if (ext.length() < 1) { return false; }
+            for (size_t i = 0; i < sizeof(ALLOWED_FILES) / sizeof(std::string_view); i++) {
+                if (Utils::strIEquals(ext, ALLOWED_FILES[i])) {
+                    return true;
                 }
+            }
+            return false;
+        };
+
+        // A zipped frame path is read in place, entries are only extracted when decoded.
+        std::shared_ptr<ZipArchive> archive{};
+        bool hasFiles = false;
+        if (Utils::endsWith(path, ".zip", false)) {
+            archive = std::make_shared<ZipArchive>();
+            if (!archive->open(path)) {
+                JCORE_WARN("Failed to prepare Projection '{0}': Couldn't open archive '{1}'!", material.nameID, path);
                 return false;
-            })) {
+            }
+            hasFiles = archive->getEntryCount() > 0;
+        }
+        else if (index && index->getFiles(path, indexed)) {
+            // Already crawled with the rest of the source, no need to walk the directory again.
+            indexed.erase(std::remove_if(indexed.begin(), indexed.end(), [&isAllowed](const FileIndex::Entry* file) {
+                return !isAllowed(fs::path(file->getName()));
+                }), indexed.end());
+            hasFiles = indexed.size() > 0;
+        }
+        else {
+            hasFiles = IO::getAll(path, IO::F_TYPE_FILE, paths, true, isAllowed);
+        }
+
+        if (hasFiles || sheets.size() > 0 || streams.size() > 0) {
             int32_t lowest = INT32_MAX;
             int32_t highest = 0;
 
             std::string tempStr{};
             std::string_view temp{};
+            if (archive) {
+                for (size_t i = 0; i < archive->getEntryCount(); i++) {
+                    const std::string& name = archive->getEntry(i).name;
+                    size_t slash = name.find_last_of('/');
+                    temp = slash == std::string::npos ? std::string_view(name) : std::string_view(name).substr(slash + 1);
+
+                    if (!isAllowed(fs::path(temp)) || !Utils::startsWith(temp, "Frame", false)) {
+                        continue;
+                    }
+
+                    PFrameIndex idx(temp);
+                    tempPaths.emplace_back(archive, i, idx);
+
+                    int32_t frameIdx = int32_t(idx.getIndex());
+                    lowest = Math::min<int32_t>(frameIdx, lowest);
+                    highest = Math::max<int32_t>(frameIdx, highest);
+                }
+            }
+
+            for (auto file : indexed) {
+                temp = file->getName();
+                if (!Utils::startsWith(temp, "Frame", false)) {
+                    continue;
+                }
+
+                PFrameIndex idx(temp);
+                tempPaths.emplace_back(temp, idx).fileSize = file->size;
+
+                int32_t frameIdx = int32_t(idx.getIndex());
+                lowest = Math::min<int32_t>(frameIdx, lowest);
+                highest = Math::max<int32_t>(frameIdx, highest);
+            }
+
             for (size_t i = 0; i < paths.size(); i++) {
                 tempStr = paths[i].string();
                 temp = IO::getName(tempStr);
@@ -298,6 +607,61 @@ namespace Projections {
                 highest = Math::max<int32_t>(frameIdx, highest);
             }
 
+            // Sheet cells are added after loose files so they take precedence over them.
+            // Entries naming the same sheet share one decoded copy of it.
+            std::unordered_map<std::string, std::shared_ptr<SheetSource>> sources{};
+            std::vector<SheetRect> cells{};
+            size_t sliced = 0;
+            for (auto& sheet : sheets) {
+                if (!sheet.getCells(path, cells)) {
+                    JCORE_WARN("Skipping sprite sheet '{}' of '{}'", sheet.path, material.nameID);
+                    continue;
+                }
+
+                auto& source = sources[sheet.path];
+                if (!source) {
+                    source = std::make_shared<SheetSource>(sheet.path);
+                }
+
+                for (size_t i = 0; i < cells.size(); i++) {
+                    if (cells[i].width < 1) { continue; }
+
+                    PFrameIndex idx(int32_t(sheet.startFrame + i), sheet.layer, sheet.emission);
+                    tempPaths.emplace_back(source, cells[i], i, idx);
+
+                    int32_t frameIdx = int32_t(idx.getIndex());
+                    lowest = Math::min<int32_t>(frameIdx, lowest);
+                    highest = Math::max<int32_t>(frameIdx, highest);
+                    sliced++;
+                }
+            }
+            if (sliced > 0) {
+                JCORE_TRACE("Sliced {} frames out of {} sprite sheets for '{}'", sliced, sources.size(), material.nameID);
+            }
+
+            // Raw streams go last, their frames are copied straight out of the stream.
+            size_t streamed = 0;
+            for (auto& rawStream : streams) {
+                auto source = std::make_shared<StreamSource>(rawStream.path, rawStream.width, rawStream.height);
+                if (!source->open(path, size_t(rawStream.frameCount))) {
+                    JCORE_WARN("Skipping raw stream '{}' of '{}'", rawStream.path, material.nameID);
+                    continue;
+                }
+
+                for (size_t i = 0; i < source->getFrameCount(); i++) {
+                    PFrameIndex idx(int32_t(rawStream.startFrame + i), rawStream.layer, rawStream.emission);
+                    tempPaths.emplace_back(source, i, idx);
+
+                    int32_t frameIdx = int32_t(idx.getIndex());
+                    lowest = Math::min<int32_t>(frameIdx, lowest);
+                    highest = Math::max<int32_t>(frameIdx, highest);
+                    streamed++;
+                }
+            }
+            if (streamed > 0) {
+                JCORE_TRACE("Read {} frames out of {} raw streams for '{}'", streamed, streams.size(), material.nameID);
+            }
+
             if (highest < lowest) {
 
                 JCORE_WARN("Failed to prepare frames for '{0}'!", material.nameID);
@@ -318,7 +682,6 @@ namespace Projections {
             width = 0;
             height = 0;
 
-            ImageData tempData{};
             for (auto& tmp : tempPaths) {
                 auto& idx = tmp.index;
                 if (idx.getLayer() >= layers.size()) {
@@ -329,16 +692,15 @@ namespace Projections {
 
                 size_t tgt = index * layers.size() + idx.getLayer();
                 (idx.isEmissive() ? frames[tgt].pathE : frames[tgt].path) = tmp;
+            }
 
-                if ((width < 1 || height < 1) && tmp.getInfo(tempData, path)) {
-                    width = tempData.width;
-                    height = tempData.height;
+            if (!validateSources(frames, path, material.nameID, width, height)) {
+                return false;
+            }
 
-                    if (width > PROJ_MAX_RESOLUTION || height >= PROJ_MAX_RESOLUTION) {
-                        JCORE_ERROR("Failed to prepare '{}'! (Frame resolution {}x{} is larger than max of {})", material.nameID, width, height, PROJ_MAX_RESOLUTION);
-                        return false;
-                    }
-                }
+            if (width > PROJ_MAX_RESOLUTION || height >= PROJ_MAX_RESOLUTION) {
+                JCORE_ERROR("Failed to prepare '{}'! (Frame resolution {}x{} is larger than max of {})", material.nameID, width, height, PROJ_MAX_RESOLUTION);
+                return false;
             }
 
             for (auto& inf : frameInfo) {
@@ -357,6 +719,11 @@ namespace Projections {
                 //}
             }
 
+            size_t aliases = findAliasedSources(frames, path);
+            if (aliases > 0) {
+                JCORE_TRACE("Found {} byte identical frame sources in '{}'", aliases, material.nameID);
+            }
+
             if (!audioInfo.prepare(material.root)) {
                 JCORE_WARN("Failed to prepare audio for '{}'! (One or more audio variants were invalid, no audio will be exported!)", material.nameID);
             }
@@ -375,7 +742,7 @@ namespace Projections {
         uint32_t index{};
         constexpr FramePointer(uint32_t value) : index(value) {}
         constexpr FramePointer(uint32_t frame, uint32_t layer, bool isEmission) : 
-            index((layer & 0x7FFFFFU) | ((layer & 0x7FU) << 23) | (isEmission ? 0x40000000U : 0x00) | 0x80000000U)
+            index((frame & 0x7FFFFFU) | ((layer & 0x7FU) << 23) | (isEmission ? 0x40000000U : 0x00) | 0x80000000U)
         {}
 
         constexpr FramePointer(uint32_t size, bool isCompressed) :
@@ -400,142 +767,511 @@ namespace Projections {
         layer = current % layerC;
     }
 
-    static FramePointer indexOfCrcBlock(const CRCBlocks& block, const PrFrame* frames, uint32_t current, uint32_t layerC, bool isEmission) {
-        uint32_t fr{0}, lr{ 0 };
-        for (uint32_t i = 0; i < current; i++) {
-            if (frames[i].block[0] == block) {
-                parseFrameIndex(i, layerC, fr, lr);
-                return FramePointer(fr, lr, false);
-            }
+    static FramePointer getSlotPointer(int32_t index, int32_t layerC, bool isEmission) {
+        uint32_t fr{ 0 }, lr{ 0 };
+        parseFrameIndex(uint32_t(index), uint32_t(layerC), fr, lr);
+        return FramePointer(fr, lr, isEmission);
+    }
 
-            if (frames[i].block[0] == block) {
-                parseFrameIndex(i, layerC, fr, lr);
-                return FramePointer(fr, lr, true);
+    // Compares two decoded sources by their clipped RGBA32 pixels, converted in small blocks
+    // so sources of different formats compare equal, and in place clipped sources still match.
+    static bool isSameFrame(const ImageData& lhs, const ImageData& rhs, uint8_t alphaClip) {
+        if (lhs.width != rhs.width || lhs.height != rhs.height) { return false; }
+
+        static constexpr size_t BLOCK_SIZE = 1024;
+        Color32 lhsBlock[BLOCK_SIZE];
+        Color32 rhsBlock[BLOCK_SIZE];
+        ColorConverter lhsConv(lhs, alphaClip);
+        ColorConverter rhsConv(rhs, alphaClip);
+
+        size_t reso = size_t(lhs.width) * lhs.height;
+        for (size_t i = 0; i < reso; i += BLOCK_SIZE) {
+            size_t count = Math::min(BLOCK_SIZE, reso - i);
+            lhsConv.convert(i, count, lhsBlock);
+            rhsConv.convert(i, count, rhsBlock);
+            if (memcmp(lhsBlock, rhsBlock, count * sizeof(Color32)) != 0) {
+                return false;
             }
         }
-        if (isEmission && frames[current].block[0] == frames[current].block[1]) {
-            parseFrameIndex(current, layerC, fr, lr);
-            return FramePointer(fr, lr, true);
+        return true;
+    }
+
+    // Looks up earlier slots with the same content key. The full hash and the resolution recorded
+    // during prepare filter out nearly every miss without touching the source, a remaining hit
+    // is only accepted if the candidate's decoded source has the same clipped pixels as 'readBuffer'.
+    static FramePointer findDuplicate(const FrameHash& hash, const PrFrame* frames, uint32_t layerC, std::string_view framePath, PBuffers& buffers, uint8_t alphaClip) {
+        const ImageData& current = buffers.readBuffer;
+        auto range = buffers.frameIndex.equal_range(hash.getKey());
+        for (auto it = range.first; it != range.second; ++it) {
+            uint32_t slot = it->second;
+            bool isEmission = (slot & 0x1) != 0;
+            const PrFrame& other = frames[slot >> 1];
+            const PFramePath& otherPath = isEmission ? other.pathE : other.path;
+            if (other.hash[isEmission ? 1 : 0] != hash || otherPath.width != current.width || otherPath.height != current.height) { continue; }
+
+            if (!otherPath.decodeImage(buffers.compareBuffer, framePath) ||
+                !isSameFrame(current, buffers.compareBuffer, alphaClip)) {
+                continue;
+            }
+            return getSlotPointer(int32_t(slot >> 1), int32_t(layerC), isEmission);
         }
         return EmptyFrame;
     }
 
+    // Decodes a frame source and returns the image holding its clipped RGBA32 pixels. RGBA32 sources
+    // are clipped in place in 'readBuffer', only other formats get converted into 'frameBuffer'.
+    static ImageData* decodeFrame(const PFramePath& path, std::string_view framePath, ImageData& readBuffer, ImageData& frameBuffer, uint8_t alphaClip) {
+        if (!path.isValid() || !path.decodeImage(readBuffer, framePath)) {
+            return nullptr;
+        }
+
+        if (readBuffer.format == TextureFormat::RGBA32) {
+            readAsColor32(readBuffer, reinterpret_cast<Color32*>(readBuffer.data), alphaClip);
+            return &readBuffer;
+        }
+
+        if (!frameBuffer.doAllocate(readBuffer.width, readBuffer.height, TextureFormat::RGBA32)) {
+            return nullptr;
+        }
+        readAsColor32(readBuffer, reinterpret_cast<Color32*>(frameBuffer.data), alphaClip);
+        return &frameBuffer;
+    }
+
+    // Scratch state of a single thread in the frame analysis passes.
+    struct FrameWorker {
+        ImageData readBuffer{};
+        ImageData frameBuffer{};
+        ColorHistogram histogram{};
+        std::vector<uint64_t> scratch{};
+
+        ~FrameWorker() {
+            readBuffer.clear(true);
+            frameBuffer.clear(true);
+        }
+    };
+
+    // Remaps the frame's 16-bit indices to 8-bit indices into a local table of
+    // global indices, returns the table size or -1 if the frame uses over 256 colors.
+    static int32_t buildLocalPalette(PBuffers& buffers, int32_t reso) {
+        int16_t* localMap = buffers.localMap.data();
+        int32_t count = 0;
+
+        uint16_t prev = 0;
+        int16_t prevLocal = -1;
+        for (int32_t i = 0; i < reso; i++) {
+            uint16_t ind = buffers.idxUI16[i];
+            if (ind != prev || prevLocal < 0) {
+                prev = ind;
+                prevLocal = localMap[ind];
+                if (prevLocal < 0) {
+                    if (count >= 256) {
+                        count = -1;
+                        break;
+                    }
+                    prevLocal = localMap[ind] = int16_t(count);
+                    buffers.localTable[count++] = ind;
+                }
+            }
+            buffers.idxUI8[i] = uint8_t(prevLocal);
+        }
+
+        int32_t used = count < 0 ? 256 : count;
+        for (int32_t i = 0; i < used; i++) {
+            localMap[buffers.localTable[i]] = -1;
+        }
+        return count;
+    }
+
+    // Maps a frame's pixels to palette indices. Both the planned and the
+    // incremental palette go through it, so the fused and multi-pass frame paths index identically.
+    struct IndexMapper {
+        PBuffers& buffers;
+        const FramePlan* plan{};
+        uint8_t imageMode{};
+        uint16_t pOffset{};
+
+        IndexMapper(PBuffers& buffers, const FramePlan* plan) : buffers(buffers), plan(plan) {
+            if (plan) {
+                imageMode = (plan->imageMode == PIMG_Indexed8 || plan->imageMode == PIMG_Indexed16) ? plan->imageMode : PIMG_RGBA32;
+                pOffset = plan->pOffset;
+            }
+            else {
+                imageMode = buffers.palette.count > 256 ? PIMG_Indexed16 : PIMG_Indexed8;
+            }
+        }
+
+        void map(const Color32* pixels, size_t start, size_t count) {
+            auto& palette = buffers.palette;
+            size_t end = start + count;
+            if (plan) {
+                bool valid = true;
+                switch (imageMode) {
+                    case PIMG_Indexed8:
+                        for (size_t i = start; i < end; i++) {
+                            int32_t ind = palette.lookup(pixels[i]) - pOffset;
+                            valid &= uint32_t(ind) < 256U;
+                            buffers.idxUI8[i] = uint8_t(ind);
+                        }
+                        break;
+                    case PIMG_Indexed16:
+                        for (size_t i = start; i < end; i++) {
+                            int32_t ind = palette.lookup(pixels[i]);
+                            valid &= ind >= 0;
+                            buffers.idxUI16[i] = uint16_t(ind);
+                        }
+                        break;
+                }
+
+                if (!valid) {
+                    imageMode = PIMG_RGBA32;
+                    pOffset = 0;
+                }
+                return;
+            }
+
+            for (size_t i = start; i < end && imageMode != PIMG_RGBA32; i++) {
+                int32_t ind = palette.add(pixels[i]);
+                if (ind < 0) {
+                    palette.rollback();
+                    imageMode = PIMG_RGBA32;
+                    break;
+                }
+
+                if (palette.count > 256 && imageMode == PIMG_Indexed8) {
+                    Kernels::widenUI8(buffers.idxUI8, buffers.idxUI16, i);
+                    imageMode = PIMG_Indexed16;
+                }
+
+                if (imageMode == PIMG_Indexed8) {
+                    buffers.idxUI8[i] = uint8_t(ind);
+                }
+                else {
+                    buffers.idxUI16[i] = uint16_t(ind);
+                }
+            }
+        }
+
+        // Narrows 16-bit frames that span under 256 entries and commits new palette entries.
+        uint8_t finish(size_t reso, uint16_t& offset) {
+            if (!plan) {
+                uint16_t lowest = 0, highest = 0;
+                if (imageMode == PIMG_Indexed16 && reso > 0) {
+                    Kernels::rangeUI16(buffers.idxUI16, reso, lowest, highest);
+                }
+
+                if (imageMode == PIMG_Indexed16 && highest - lowest < 256) {
+                    pOffset = lowest;
+                    Kernels::narrowUI16(buffers.idxUI16, buffers.idxUI8, reso, pOffset);
+                    imageMode = PIMG_Indexed8;
+                }
+
+                if (imageMode != PIMG_RGBA32) {
+                    buffers.palette.commit();
+                }
+            }
+            offset = pOffset;
+            return imageMode;
+        }
+    };
+
+    // 16 KB of RGBA32 per block, a multiple of FrameHash::STRIDE so the streamed hash matches.
+    static constexpr size_t FUSED_BLOCK_SIZE = 4096;
+
+    // Single cache blocked pass over a decoded frame: converts and clips a block and streams it into
+    // the fingerprint while the block is still in L1. Leading empty blocks aren't hashed until a
+    // non-empty block shows up, the hash of zeroes from a zero state is zero so skipping them doesn't
+    // change the result. Palette indices are only mapped once the frame is known to be written.
+    static void processFused(const ImageData& src, Color32* pixels, uint8_t alphaClip, FrameHash& hash) {
+        ColorConverter converter(src, alphaClip);
+        size_t reso = size_t(src.width) * src.height;
+
+        hash.clear();
+        bool isLeading = true;
+        for (size_t i = 0; i < reso; i += FUSED_BLOCK_SIZE) {
+            size_t count = Math::min(FUSED_BLOCK_SIZE, reso - i);
+            converter.convert(i, count, pixels + i);
+            if (isLeading && Kernels::isZero(pixels + i, count)) { continue; }
+
+            isLeading = false;
+            hash.update(reinterpret_cast<const uint8_t*>(pixels + i), count * sizeof(Color32));
+        }
+    }
+
+    // Reruns the multi-pass conversion and fingerprint on an unmodified decode of the frame and checks
+    // the fused pass against it, indices are checked against the palette entries they point to.
+    // RGBA32 sources were clipped in place by the fused pass, so those are decoded again.
+    static bool verifyFused(PBuffers& buffers, const PFramePath& path, std::string_view framePath,
+        const Color32* pixels, const FrameHash& hash, uint8_t imageMode, uint16_t pOffset, uint8_t alphaClip) {
+        auto& reference = buffers.compareBuffer;
+        if (buffers.readBuffer.format == TextureFormat::RGBA32) {
+            if (!path.decodeImage(reference, framePath) || reference.format != TextureFormat::RGBA32 ||
+                reference.width != buffers.readBuffer.width || reference.height != buffers.readBuffer.height) {
+                return false;
+            }
+            readAsColor32(reference, reinterpret_cast<Color32*>(reference.data), alphaClip);
+        }
+        else {
+            if (!reference.doAllocate(buffers.readBuffer.width, buffers.readBuffer.height, TextureFormat::RGBA32)) { return false; }
+            readAsColor32(buffers.readBuffer, reinterpret_cast<Color32*>(reference.data), alphaClip);
+        }
+
+        FrameHash referenceHash{};
+        referenceHash.from(reference.data, reference.getSize());
+
+        size_t reso = size_t(reference.width) * reference.height;
+        bool valid = referenceHash == hash && memcmp(pixels, reference.data, reso * sizeof(Color32)) == 0;
+
+        const uint32_t* values = reinterpret_cast<const uint32_t*>(pixels);
+        const uint32_t* colors = reinterpret_cast<const uint32_t*>(buffers.palette.colors);
+        for (size_t i = 0; i < reso && valid; i++) {
+            switch (imageMode) {
+                case PIMG_Indexed8:
+                    valid = colors[size_t(buffers.idxUI8[i]) + pOffset] == values[i];
+                    break;
+                case PIMG_Indexed16:
+                    valid = colors[buffers.idxUI16[i]] == values[i];
+                    break;
+            }
+        }
+        return valid;
+    }
+
+    // Encodes a frame for the shared store, blobs can't depend on any projection's palette.
+    // Blob: mode (uint8, 0 = RGBA32, 1 = local colors), compressed (uint8), color count (uint16),
+    // premultiplied colors, then the pixel or index data.
+    static void encodeSharedFrame(Color32* pixels, int32_t reso, float minCompression, std::vector<uint8_t>& blob, uint8_t* indices) {
+        blob.clear();
+        BlobWriter writer{ blob };
+
+        std::unordered_map<uint32_t, uint8_t> lookup{};
+        Color32 colors[256]{};
+        size_t colorCount = 0;
+
+        const uint32_t* values = reinterpret_cast<const uint32_t*>(pixels);
+        uint32_t prev = ~values[0];
+        uint8_t prevIndex = 0;
+        bool isLocal = true;
+        for (int32_t i = 0; i < reso; i++) {
+            if (values[i] != prev) {
+                auto it = lookup.find(values[i]);
+                if (it == lookup.end()) {
+                    if (colorCount >= 256) {
+                        isLocal = false;
+                        break;
+                    }
+                    it = lookup.emplace(values[i], uint8_t(colorCount)).first;
+                    colors[colorCount++] = pixels[i];
+                }
+                prev = values[i];
+                prevIndex = it->second;
+            }
+            indices[i] = prevIndex;
+        }
+
+        writer.writeValue(uint8_t(isLocal ? 1 : 0));
+        writer.writeValue(uint8_t(0));
+        writer.writeValue(uint16_t(isLocal ? colorCount : 0));
+
+        size_t rawSize{};
+        const void* raw{};
+        int32_t bWrite{};
+        if (isLocal) {
+            Kernels::premultiplyRGBA32(colors, colorCount);
+            writer.write(colors, colorCount * sizeof(Color32), false);
+
+            rawSize = size_t(reso);
+            raw = indices;
+            bWrite = applyRLE_Normal(writer, reso, indices);
+        }
+        else {
+            Kernels::premultiplyRGBA32(pixels, size_t(reso));
+
+            rawSize = size_t(reso) * sizeof(Color32);
+            raw = pixels;
+            bWrite = applyRLE_Normal(writer, reso, pixels);
+        }
+
+        size_t tableSize = isLocal ? colorCount * sizeof(Color32) : 0;
+        if (getCompressionRatio(size_t(bWrite), rawSize, tableSize) < minCompression) {
+            blob.resize(blob.size() - size_t(bWrite));
+            writer.write(raw, rawSize, false);
+        }
+        else {
+            blob[1] = 1;
+        }
+    }
+
     static void writeFrameData(std::string_view framePath, int32_t index, PrFrame* frames, int32_t layerC, const Stream& stream,
         PBuffers& buffers, bool altTex, float minCompression = 0.25f, uint8_t alphaClip = 8) {
 
         auto& frame = frames[index];
         PFramePath* path = (altTex ? &frame.pathE : &frame.path);
-        CRCBlocks* crcBlock = (altTex ? &frame.block[1] : &frame.block[0]);
+        FrameHash* hash = (altTex ? &frame.hash[1] : &frame.hash[0]);
+
+        uint32_t slot = uint32_t(index) * 2 + (altTex ? 1 : 0);
+        if (path->isAlias() && path->aliasOf < slot) {
+            FramePointer ptr = buffers.slotPointers[path->aliasOf];
+            *hash = frames[path->aliasOf >> 1].hash[path->aliasOf & 0x1];
+            buffers.slotPointers[slot] = ptr.index;
+            stream.writeValue(ptr);
+            stream.writeZero(3);
+            return;
+        }
 
         TaskManager::waitForBuffer();
-        if (path->isValid() && 
-            path->decodeImage(buffers.readBuffer, framePath) &&
-            buffers.frameBuffer.doAllocate(buffers.readBuffer.width, buffers.readBuffer.height, TextureFormat::RGBA32)) {
-            Color32* pixels = reinterpret_cast<Color32*>(buffers.frameBuffer.data);
-            readAsColor32(buffers.readBuffer, pixels, alphaClip);
+        if (path->isValid() && path->decodeImage(buffers.readBuffer, framePath)) {
+            // Duplicates are matched on the resolution read during prepare, a source
+            // changed since then can't be written in its place.
+            if (buffers.readBuffer.width != path->width || buffers.readBuffer.height != path->height) {
+                JCORE_ERROR("'{}' is {}x{} but was {}x{} when prepared, reload the projection!",
+                    path->path, buffers.readBuffer.width, buffers.readBuffer.height, path->width, path->height);
+                goto noData;
+            }
+
+            // Quantizing needs the whole frame before it can be indexed, so it keeps the multi-pass path.
+            bool isFused = !buffers.useQuantizer;
+
+            // RGBA32 sources are worked on in place, quantized frames keep the source intact
+            // since duplicate checks compare against it.
+            ImageData* image = &buffers.readBuffer;
+            if (!isFused || buffers.readBuffer.format != TextureFormat::RGBA32) {
+                if (!buffers.frameBuffer.doAllocate(buffers.readBuffer.width, buffers.readBuffer.height, TextureFormat::RGBA32)) {
+                    goto noData;
+                }
+                image = &buffers.frameBuffer;
+            }
+
+            Color32* pixels = reinterpret_cast<Color32*>(image->data);
+            int32_t reso = image->width * image->height;
+            bool isEmpty = false;
+            if (isFused) {
+                processFused(buffers.readBuffer, pixels, alphaClip, *hash);
+                isEmpty = hash->isZero();
+            }
+            else {
+                readAsColor32(buffers.readBuffer, pixels, alphaClip);
+                buffers.quantizer.apply(pixels, image->width, image->height, buffers.dither, &buffers.quantizeStats);
+
+                isEmpty = Kernels::isZero(pixels, size_t(reso));
+                if (isEmpty) {
+                    hash->clear();
+                }
+                else {
+                    auto hashStart = std::chrono::high_resolution_clock::now();
+                    hash->from(image->data, image->getSize());
+                    buffers.hashSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - hashStart).count();
+                    buffers.hashedBytes += image->getSize();
+                }
+            }
 
             REPORT_PROGRESS(
-                TaskManager::reportPreview(&buffers.frameBuffer);
+                TaskManager::reportPreview(image);
             );
 
-            bool isEmpty = !crcBlock->from(buffers.frameBuffer.data, buffers.frameBuffer.getSize());
             if (isEmpty) {
+                buffers.emptyFrames++;
                 goto noData;
             }
 
-            FramePointer ptr = indexOfCrcBlock(*crcBlock, frames, index, layerC, altTex);
+            FramePointer ptr = findDuplicate(*hash, frames, uint32_t(layerC), framePath, buffers, alphaClip);
             if (ptr != EmptyFrame) {
-                stream.writeValue(EmptyFrame);
+                buffers.slotPointers[slot] = ptr.index;
+                stream.writeValue(ptr);
                 stream.writeZero(3);
                 return;
             }
 
+            if (buffers.store) {
+                uint64_t key = FrameStore::makeKey(*hash, image->width, image->height);
+                if (buffers.store->isShared(key)) {
+                    encodeSharedFrame(pixels, reso, minCompression, buffers.sharedBlob, buffers.idxUI8);
+                    uint32_t id = buffers.store->add(key, buffers.sharedBlob.data(), buffers.sharedBlob.size());
+
+                    stream.writeValue(FramePointer(uint32_t(sizeof(uint32_t)), false));
+                    stream.writeValue(uint8_t(PIMG_Shared));
+                    stream.writeValue(uint16_t(0));
+                    stream.writeValue(id);
+                    buffers.frameIndex.emplace(hash->getKey(), slot);
+                    buffers.slotPointers[slot] = getSlotPointer(index, layerC, altTex).index;
+                    return;
+                }
+            }
+
             static constexpr size_t DATA_OFFSET = sizeof(FramePointer) + sizeof(uint16_t) + sizeof(uint8_t);
-            int32_t reso = buffers.frameBuffer.width * buffers.frameBuffer.height;
             int32_t ogSize = reso * sizeof(Color32);
-            
+
+            // Only frames that are actually written get mapped, so their colors never have to be rolled back.
+            IndexMapper mapper(buffers, buffers.usePlan ? &buffers.framePlans[slot] : nullptr);
+            mapper.map(pixels, 0, size_t(reso));
             uint16_t pOffset = 0;
-            uint8_t imageMode = buffers.palette.count > 256 ? 0x2 : 0x1;
-            int32_t lowest = INT_MAX;
-            int32_t highest = 0;
-            for (int32_t i = 0; i < reso && imageMode > 0; i++) {
-                int32_t ind = buffers.palette.add(pixels[i]);
-                if (ind < 0) {
-                    memcpy(&buffers.palette, &buffers.palettePrev, sizeof(buffers.palettePrev));
-                    imageMode = 0;
-                    break;
-                }
-                else {
-                    if (buffers.palette.count > 256 && imageMode == 1) {
-                        for (size_t j = 0; j < i; j++) {
-                            buffers.idxUI16[j] = buffers.idxUI8[j];
-                        }
-                        imageMode = 2;
-                    }
+            uint8_t imageMode = mapper.finish(size_t(reso), pOffset);
 
-                    if (imageMode == 1) {
-                        buffers.idxUI8[i] = uint8_t(ind);
-                    }
-                    else {
-                        buffers.idxUI16[i] = uint16_t(ind);
-                    }
-                    lowest = Math::min(ind, lowest);
-                    highest = Math::max(ind, highest);
-                }
+            if (isFused && buffers.settings.verifyFused && !verifyFused(buffers, *path, framePath, pixels, *hash, imageMode, pOffset, alphaClip)) {
+                JCORE_ERROR("Fused frame pass doesn't match the multi-pass reference for '{}'!", path->path);
             }
 
-            if (imageMode == 2) {
-                int32_t diff = highest - lowest;
-                if (diff <= 256) {
-                    pOffset = uint16_t(lowest);
-                    for (size_t i = 0; i < reso; i++) {
-                        buffers.idxUI8[i] = uint8_t(buffers.idxUI16[i] - pOffset);
+            // Frames with few colors scattered across the global palette can be
+            // cheaper as 8-bit local indices plus a small table of global ones.
+            // Both layouts are sized as they'd be written, RLE included.
+            size_t tableSize = 0;
+            if (imageMode == PIMG_Indexed16) {
+                int32_t localCount = buildLocalPalette(buffers, reso);
+                if (localCount > 0) {
+                    size_t localTable = size_t(localCount) * sizeof(uint16_t);
+                    size_t wideSize = getPayloadSize(applyRLE_Normal(NullWriter{}, reso, buffers.idxUI16), size_t(reso) * sizeof(uint16_t), 0, minCompression);
+                    size_t localSize = getPayloadSize(applyRLE_Normal(NullWriter{}, reso, buffers.idxUI8), size_t(reso), localTable, minCompression);
+                    if (localSize < wideSize) {
+                        imageMode = PIMG_Local8;
+                        pOffset = uint16_t(localCount);
+                        tableSize = localTable;
                     }
-                    imageMode = 1;
                 }
             }
 
-            if (imageMode != 0) {
-                memcpy(&buffers.palettePrev, &buffers.palette, sizeof(buffers.palette));
-            }
-
             size_t pos = stream.tell();
             stream.writeValue(ptr);
             stream.writeValue(imageMode);
             stream.writeValue(pOffset);
+            if (tableSize > 0) {
+                stream.write(buffers.localTable, tableSize, false);
+            }
             int32_t bWrite = 0;
             void* bufferToWrite = 0;
 
+            // Premultiply before encoding so RLE and raw output both carry the final colors.
+            if (imageMode == PIMG_RGBA32) {
+                Kernels::premultiplyRGBA32(pixels, size_t(reso));
+            }
+
             switch (imageMode)
             {
             default:
                 bWrite = applyRLE_Normal(stream, reso, pixels);
                 bufferToWrite = pixels;
                 break;
-            case 1:
+            case PIMG_Indexed8:
+            case PIMG_Local8:
                 ogSize = reso;
                 bWrite = applyRLE_Normal(stream, reso, buffers.idxUI8);
                 bufferToWrite = buffers.idxUI8;
                 break;
-            case 2:
+            case PIMG_Indexed16:
                 ogSize = reso * 2;
                 bWrite = applyRLE_Normal(stream, reso, buffers.idxUI16);
                 bufferToWrite = buffers.idxUI16;
                 break;
             }
-            float pr = 1.0f - ((float(bWrite) / ogSize));
-            if (imageMode == 0) {
-                for (int32_t i = 0; i < reso; i++) {
-                    premultiplyC32(pixels[i]);
-                }
-            }
+            float pr = getCompressionRatio(size_t(bWrite), size_t(ogSize), tableSize);
 
             if (pr < minCompression) {
                 stream.seek(pos, SEEK_SET);
-                ptr = FramePointer(uint32_t(ogSize), false);
+                ptr = FramePointer(uint32_t(ogSize + tableSize), false);
                 stream.writeValue(ptr);
                 stream.writeValue(imageMode);
                 stream.writeValue(pOffset);
+                if (tableSize > 0) {
+                    stream.write(buffers.localTable, tableSize, false);
+                }
                 stream.write(bufferToWrite, ogSize, false);
             }
             else {
@@ -548,9 +1284,12 @@ namespace Projections {
                 stream.writeValue(pOffset);
                 stream.seek(endPos, SEEK_SET);
             }
+            buffers.frameIndex.emplace(hash->getKey(), slot);
+            buffers.slotPointers[slot] = getSlotPointer(index, layerC, altTex).index;
             return;
         }
     noData:
+        buffers.slotPointers[slot] = EmptyFrame.index;
         stream.writeValue(EmptyFrame);
         stream.writeZero(3);
     }
@@ -567,19 +1306,260 @@ namespace Projections {
         }
     }
 
+    static void prepareQuantizer(const Projection& proj, PBuffers& buffers) {
+        buffers.useQuantizer = false;
+        buffers.quantizeStats.reset();
+        buffers.quantizer.clear();
+        if (!proj.quantize.enabled || !proj.analysis.isValid) { return; }
+
+        const ColorHistogram& histogram = proj.analysis.histogram;
+        if (histogram.size() <= size_t(proj.quantize.colors)) {
+            JCORE_TRACE("'{}' already fits in {} colors, skipping quantization", proj.material.nameID, proj.quantize.colors);
+            return;
+        }
+
+        if (!buffers.quantizer.build(histogram, proj.quantize.colors)) {
+            JCORE_WARN("Failed to build quantized palette for '{}'!", proj.material.nameID);
+            return;
+        }
+
+        double psnr = buffers.quantizer.estimatePSNR(histogram);
+        if (psnr < proj.quantize.minPSNR) {
+            JCORE_WARN("Skipping quantization of '{}'! (Estimated PSNR {:.2f} dB is below the minimum of {:.2f} dB)", proj.material.nameID, psnr, proj.quantize.minPSNR);
+            return;
+        }
+
+        JCORE_INFO("Quantizing '{}' from {} to {} colors (Estimated PSNR {:.2f} dB)", proj.material.nameID, histogram.size(), buffers.quantizer.getColorCount(), psnr);
+        buffers.useQuantizer = true;
+        buffers.dither = proj.quantize.dither;
+    }
+
+    // Fixes the projection's palette up front from its analysis pass, frequency sorted so common
+    // colors get the smallest indices, and every frame's index width before anything is encoded.
+    static void planPalette(const Projection& proj, FrameAnalysis& analysis, PBuffers& buffers) {
+        buffers.usePlan = false;
+        buffers.framePlans.clear();
+        if (!buffers.settings.planPalettes || !analysis.isValid || !analysis.hasColors) { return; }
+
+        size_t slots = proj.frames.size() * 2;
+        std::vector<std::pair<uint32_t, uint64_t>> sorted{};
+        if (buffers.useQuantizer) {
+            // Quantized frames only hold quantizer colors, ordered by how many source pixels map to each.
+            const auto& quantizer = buffers.quantizer;
+            sorted.resize(size_t(quantizer.getColorCount()));
+            for (int32_t i = 0; i < quantizer.getColorCount(); i++) {
+                sorted[i].first = reinterpret_cast<const uint32_t&>(quantizer.getColors()[i]);
+            }
+            for (auto& pair : analysis.histogram.counts) {
+                sorted[quantizer.findNearest(reinterpret_cast<const Color32&>(pair.first))].second += pair.second;
+            }
+        }
+        else {
+            auto& counts = analysis.histogram.counts;
+
+            // Shared frames are written to the frame store and never index into this palette.
+            // Their colors can only be taken out again if the slot kept them, larger ones stay in.
+            if (buffers.store) {
+                for (auto& slot : analysis.slots) {
+                    if (slot.key == 0 || !buffers.store->isShared(slot.key)) { continue; }
+                    for (auto& pair : slot.colors) {
+                        auto it = counts.find(pair.first);
+                        if (it != counts.end() && (it->second -= pair.second) == 0) {
+                            counts.erase(it);
+                        }
+                    }
+                    slot.uniqueCount = 0;
+                }
+            }
+            sorted.assign(counts.begin(), counts.end());
+        }
+        analysis.histogram.clear();
+
+        std::sort(sorted.begin(), sorted.end(), [](const std::pair<uint32_t, uint64_t>& lhs, const std::pair<uint32_t, uint64_t>& rhs) {
+            return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+            });
+
+        std::vector<uint32_t> colors{};
+        colors.reserve(Math::min<size_t>(sorted.size(), Palette::SIZE));
+        for (size_t i = 0; i < sorted.size() && colors.size() < Palette::SIZE; i++) {
+            colors.push_back(sorted[i].first);
+        }
+        if (!buffers.palette.setColors(colors.data(), int32_t(colors.size()))) {
+            JCORE_WARN("Couldn't place the planned palette of '{}' for lookup, frames are indexed as they're written", proj.material.nameID);
+            buffers.palette.clear();
+            return;
+        }
+
+        // Plans only ever pick RGBA32, Indexed8 or Indexed16.
+        int32_t modeCount[PIMG_Indexed16 + 1]{ 0 };
+        buffers.framePlans.resize(slots);
+        for (size_t i = 0; i < slots; i++) {
+            auto& slotInfo = analysis.slots[i];
+            auto& plan = buffers.framePlans[i];
+            plan = {};
+
+            if (slotInfo.uniqueCount < 1) { continue; }
+            if (buffers.useQuantizer) {
+                // The palette is the quantizer's, at most 256 colors.
+                plan.imageMode = PIMG_Indexed8;
+            }
+            else if (slotInfo.uniqueCount <= FrameAnalysis::MAX_SLOT_COLORS) {
+                int32_t lowest = INT32_MAX;
+                int32_t highest = -1;
+                for (auto& pair : slotInfo.colors) {
+                    int32_t ind = buffers.palette.indexOf(reinterpret_cast<const Color32&>(pair.first));
+                    if (ind < 0) {
+                        highest = -1;
+                        break;
+                    }
+                    lowest = Math::min(lowest, ind);
+                    highest = Math::max(highest, ind);
+                }
+
+                if (highest > -1) {
+                    if (highest - lowest < 256) {
+                        plan.imageMode = PIMG_Indexed8;
+                        plan.pOffset = uint16_t(lowest);
+                    }
+                    else {
+                        plan.imageMode = PIMG_Indexed16;
+                    }
+                }
+            }
+            else if (slotInfo.uniqueCount <= uint32_t(Palette::SIZE)) {
+                // If the palette had to be truncated, frames with colors outside of it fall back to RGBA while mapping.
+                plan.imageMode = PIMG_Indexed16;
+            }
+            modeCount[plan.imageMode]++;
+        }
+
+        buffers.usePlan = true;
+        JCORE_INFO("Planned palette for '{}': {} of {} colors (8-Bit: {}, 16-Bit: {}, RGBA32: {})",
+            proj.material.nameID, colors.size(), sorted.size(), modeCount[PIMG_Indexed8], modeCount[PIMG_Indexed16], modeCount[PIMG_RGBA32]);
+    }
+
+    void Projection::analyzeFrames(std::string_view root, bool withKeys, bool withColors) {
+        analysis.clear();
+
+        size_t slots = frames.size() * 2;
+        analysis.slots.resize(slots);
+        std::vector<FrameWorker> workers(getWorkerCount());
+        parallelFor(slots, workers.size(), [&](size_t slot, size_t w) {
+            if (TaskManager::isSkipping() || TaskManager::isCanceling()) { return; }
+
+            auto& frame = frames[slot >> 1];
+            auto& worker = workers[w];
+            auto& path = (slot & 0x1) ? frame.pathE : frame.path;
+
+            // Aliases repeat the slot they point at, which is analyzed on its own.
+            ImageData* image = path.isAlias() ? nullptr : decodeFrame(path, root, worker.readBuffer, worker.frameBuffer, 8);
+            if (!image) {
+                return;
+            }
+
+            Color32* pixels = reinterpret_cast<Color32*>(image->data);
+            size_t reso = size_t(image->width) * image->height;
+            if (reso < 1) { return; }
+
+            auto& info = analysis.slots[slot];
+            if (withKeys) {
+                FrameHash hash{};
+                if (hash.from(image->data, image->getSize())) {
+                    info.key = FrameStore::makeKey(hash, image->width, image->height);
+                }
+            }
+
+            if (!withColors) { return; }
+
+            // Collapse runs first, frames are mostly long runs so this keeps the sort small.
+            auto& scratch = worker.scratch;
+            const uint32_t* values = reinterpret_cast<const uint32_t*>(pixels);
+            scratch.clear();
+
+            uint32_t prev = values[0];
+            uint32_t run = 0;
+            for (size_t i = 0; i < reso; i++) {
+                if (values[i] != prev) {
+                    scratch.push_back((uint64_t(prev) << 32) | run);
+                    prev = values[i];
+                    run = 0;
+                }
+                run++;
+            }
+            scratch.push_back((uint64_t(prev) << 32) | run);
+            std::sort(scratch.begin(), scratch.end());
+
+            for (size_t i = 0; i < scratch.size();) {
+                uint32_t color = uint32_t(scratch[i] >> 32);
+                uint64_t total = 0;
+                while (i < scratch.size() && uint32_t(scratch[i] >> 32) == color) {
+                    total += uint32_t(scratch[i++]);
+                }
+                worker.histogram.counts[color] += total;
+
+                if (info.uniqueCount++ < FrameAnalysis::MAX_SLOT_COLORS) {
+                    info.colors.emplace_back(color, total);
+                }
+            }
+
+            if (info.uniqueCount > FrameAnalysis::MAX_SLOT_COLORS) {
+                info.colors.clear();
+                info.colors.shrink_to_fit();
+            }
+            });
+
+        if (TaskManager::isSkipping() || TaskManager::isCanceling()) {
+            analysis.clear();
+            return;
+        }
+
+        if (withColors) {
+            analysis.histogram = std::move(workers[0].histogram);
+            for (size_t i = 1; i < workers.size(); i++) {
+                analysis.histogram.merge(workers[i].histogram);
+                workers[i].histogram.clear();
+            }
+        }
+        analysis.isValid = true;
+        analysis.hasColors = withColors;
+    }
+
+    void Projection::collectFrames(FrameStore& store, uint32_t owner) {
+        // Quantized frames depend on this projection's palette and can't be shared.
+        if (quantize.enabled) { return; }
+
+        // Runs for every projection before any is written, so colors and decoded sheets
+        // aren't held on to here, write gathers them again for one projection at a time.
+        analyzeFrames(IO::combine(material.root, this->framePath), true, false);
+        for (auto& slot : analysis.slots) {
+            if (slot.key != 0) {
+                store.addReference(slot.key, owner);
+            }
+        }
+        analysis.clear();
+        releaseSheets();
+    }
+
+    void Projection::releaseSheets() {
+        for (auto& frame : frames) {
+            if (frame.path.isSliced()) { frame.path.sheet->release(); }
+            if (frame.pathE.isSliced()) { frame.pathE.sheet->release(); }
+        }
+    }
+
     bool Projection::write(const Stream& stream, PBuffers& buffers, float minCompression) {
         if (width < 1 || width > 1024 || height < 1 || height > 1024) {
             JCORE_ERROR("Failed to write '{}'! (Invalid resolution! {}x{})", material.nameID, width, height);
             return false;
         }
 
-        if (!buffers.frameBuffer.doAllocate(width, height, TextureFormat::RGBA32)) {
-            JCORE_ERROR("Failed to write '{}'! (Couldn't allocate image buffer!)", material.nameID);
-            return false;
-        }
-        buffers.palettePrev.clear();
         buffers.palette.clear();
         buffers.noPalette = false;
+        buffers.frameIndex.clear();
+        buffers.slotPointers.assign(frames.size() * 2, EmptyFrame.index);
+        buffers.hashedBytes = 0;
+        buffers.hashSeconds = 0;
+        buffers.emptyFrames = 0;
 
         int32_t lrC = Math::max<int32_t>(int32_t(layers.size()), 1);
         int32_t frameCount = int32_t(frames.size() / lrC);
@@ -590,6 +1570,14 @@ namespace Projections {
         );
         std::string framePath = IO::combine(material.root, this->framePath);
 
+        // One analysis pass feeds both the quantizer and palette planning.
+        if (quantize.enabled || buffers.settings.planPalettes) {
+            analyzeFrames(framePath, false, true);
+        }
+        prepareQuantizer(*this, buffers);
+        planPalette(*this, analysis, buffers);
+        analysis.clear();
+
         material.write(stream);
         stream.writeValue(loopStart);
         stream.writeValue(width);
@@ -635,10 +1623,28 @@ namespace Projections {
                 TaskManager::reportIncrement(2);
             );
         }
-        stream.writeValue(buffers.palette.count);
-        for (size_t i = 0; i < buffers.palette.count; i++) {
-            premultiplyC32(buffers.palette.colors[i]);
+
+        // Decoded sprite sheets are only needed while frames are being written.
+        releaseSheets();
+
+        if (buffers.useQuantizer) {
+            JCORE_INFO("Quantized '{}' with PSNR of {:.2f} dB", material.nameID, buffers.quantizeStats.getPSNR());
+        }
+
+        if (buffers.hashSeconds > 0) {
+            JCORE_TRACE("Fingerprinted {:.2f} MB for '{}' at {:.2f} GB/s ({})", buffers.hashedBytes / (1024.0 * 1024.0), material.nameID,
+                (buffers.hashedBytes / buffers.hashSeconds) / 1e9, FrameHash::hasHardwareCRC() ? "SSE4.2" : "scalar");
+        }
+
+        if (buffers.emptyFrames > 0) {
+            JCORE_TRACE("Skipped {} empty frames for '{}' before fingerprinting", buffers.emptyFrames, material.nameID);
         }
+
+        JCORE_TRACE("Palette cache for '{}': {} hits, {} misses ({:.2f}% hit rate)", material.nameID,
+            buffers.palette.cacheHits, buffers.palette.cacheMisses, buffers.palette.getCacheHitRate() * 100.0f);
+
+        stream.writeValue(buffers.palette.count);
+        Kernels::premultiplyRGBA32(buffers.palette.colors, buffers.palette.count);
         stream.write(buffers.palette.colors, sizeof(Color32) * buffers.palette.count, false);
 
         REPORT_PROGRESS(
@@ -1,6 +1,8 @@
 #include <ProjectionsGui.h>
 #include <J-Core/Log.h>
 #include <J-Core/TaskManager.h>
+#include <ParallelUtils.h>
+#include <atomic>
 using namespace JCore;
 
 namespace Projections {
@@ -57,6 +59,105 @@ namespace Projections {
             changed |= ImGui::InputText("Frame Path##Projection", &proj.framePath);
             changed |= Gui::drawEnumList("Animation Mode##Projection", proj.animMode);
 
+            if (ImGui::CollapsingHeader("Quantization")) {
+                ImGui::Indent();
+                changed |= ImGui::Checkbox("Enabled##Quantize", &proj.quantize.enabled);
+                ImGui::BeginDisabled(!proj.quantize.enabled);
+                changed |= ImGui::SliderInt("Colors##Quantize", &proj.quantize.colors, 2, PaletteQuantizer::MAX_COLORS, "%d", ImGuiSliderFlags_AlwaysClamp);
+                changed |= Gui::drawEnumList("Dithering##Quantize", proj.quantize.dither);
+                changed |= ImGui::DragFloat("Min PSNR (dB)##Quantize", &proj.quantize.minPSNR, 0.1f, 0.0f, 100.0f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+                ImGui::EndDisabled();
+                ImGui::Unindent();
+            }
+
+            if (ImGui::CollapsingHeader("Sprite Sheets")) {
+                ImGui::Indent();
+                for (size_t i = 0; i < proj.sheets.size(); i++) {
+                    ImGui::PushID(int32_t(i));
+                    if (ImGui::Button("+")) {
+                        proj.duplicateSheetAt(i);
+                        changed |= true;
+                        ImGui::PopID();
+                        break;
+                    }
+                    ImGui::SameLine();
+
+                    if (ImGui::Button("-")) {
+                        proj.removeSheetAt(i);
+                        changed |= true;
+                        ImGui::PopID();
+                        break;
+                    }
+                    ImGui::SameLine();
+
+                    auto& sheet = proj.sheets[i];
+                    if (ImGui::TreeNode("##Sheet", "Sheet #%zu (%s)", i, sheet.path.c_str())) {
+                        changed |= ImGui::InputText("Path##Sheet", &sheet.path);
+                        changed |= ImGui::InputText("Atlas##Sheet", &sheet.atlas);
+                        changed |= ImGui::SliderInt("Layer##Sheet", &sheet.layer, 0, int32_t(proj.layers.size()) - 1, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::Checkbox("Emission##Sheet", &sheet.emission);
+                        changed |= ImGui::DragInt("Start Frame##Sheet", &sheet.startFrame, 1.0f, 0, 0x7FFFFF, "%d", ImGuiSliderFlags_AlwaysClamp);
+
+                        ImGui::BeginDisabled(sheet.atlas.length() > 0);
+                        changed |= ImGui::DragInt("Frame Width##Sheet", &sheet.frameWidth, 1.0f, 0, PROJ_MAX_RESOLUTION, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Frame Height##Sheet", &sheet.frameHeight, 1.0f, 0, PROJ_MAX_RESOLUTION, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Columns##Sheet", &sheet.columns, 1.0f, 0, 4096, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Frame Count##Sheet", &sheet.frameCount, 1.0f, 0, 0x7FFFFF, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Spacing##Sheet", &sheet.spacing, 1.0f, 0, 256, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        ImGui::EndDisabled();
+                        ImGui::TreePop();
+                    }
+                    ImGui::PopID();
+                }
+
+                if (proj.sheets.size() < 1 && ImGui::Button("Add New Sheet")) {
+                    proj.sheets.emplace_back().reset();
+                    changed = true;
+                }
+                ImGui::Unindent();
+            }
+
+            if (ImGui::CollapsingHeader("Raw Streams")) {
+                ImGui::Indent();
+                for (size_t i = 0; i < proj.streams.size(); i++) {
+                    ImGui::PushID(int32_t(i));
+                    if (ImGui::Button("+")) {
+                        proj.duplicateStreamAt(i);
+                        changed |= true;
+                        ImGui::PopID();
+                        break;
+                    }
+                    ImGui::SameLine();
+
+                    if (ImGui::Button("-")) {
+                        proj.removeStreamAt(i);
+                        changed |= true;
+                        ImGui::PopID();
+                        break;
+                    }
+                    ImGui::SameLine();
+
+                    auto& stream = proj.streams[i];
+                    if (ImGui::TreeNode("##Stream", "Stream #%zu (%s)", i, stream.isStdin() ? "stdin" : stream.path.c_str())) {
+                        changed |= ImGui::InputText("Path##Stream", &stream.path);
+                        changed |= ImGui::SliderInt("Layer##Stream", &stream.layer, 0, int32_t(proj.layers.size()) - 1, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::Checkbox("Emission##Stream", &stream.emission);
+                        changed |= ImGui::DragInt("Start Frame##Stream", &stream.startFrame, 1.0f, 0, 0x7FFFFF, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Width##Stream", &stream.width, 1.0f, 0, PROJ_MAX_RESOLUTION, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Height##Stream", &stream.height, 1.0f, 0, PROJ_MAX_RESOLUTION, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        changed |= ImGui::DragInt("Frame Count##Stream", &stream.frameCount, 1.0f, 0, 0x7FFFFF, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        ImGui::TreePop();
+                    }
+                    ImGui::PopID();
+                }
+
+                if (proj.streams.size() < 1 && ImGui::Button("Add New Stream")) {
+                    proj.streams.emplace_back().reset();
+                    changed = true;
+                }
+                ImGui::Unindent();
+            }
+
             if (ImGui::CollapsingHeader("Tags")) {
                 bool tagsChanged = false;
                 ImGui::Indent();
@@ -270,6 +371,23 @@ namespace Projections {
                     char tmpSize[128]{};
                     char tmpInfo[64]{};
 
+                    FrameStore store{};
+                    auto& buffers = panel->getBuffers();
+                    buffers.store = nullptr;
+                    if (buffers.settings.sharedFrames && projections.size() > 1) {
+                        REPORT_PROGRESS(
+                            TaskManager::report(1, "Collecting shared frames...");
+                        );
+                        for (size_t i = 0; i < projections.size() && !TaskManager::isCanceling(); i++) {
+                            projections[i]->collectFrames(store, uint32_t(i));
+                        }
+
+                        JCORE_TRACE("Found {} frames shared between projections", store.getSharedCount());
+                        if (store.getSharedCount() > 0 && store.open(IO::combine(outPath, "Shared.pfrm"))) {
+                            buffers.store = &store;
+                        }
+                    }
+
                     std::chrono::steady_clock::time_point time{};
                     for (auto& proj : projections) {
                         REPORT_PROGRESS(
@@ -333,6 +451,15 @@ namespace Projections {
                         );
                     }
                     JCORE_TRACE("Exported {} Projections...", projections.size());
+                    if (buffers.store) {
+                        buffers.store = nullptr;
+                        Utils::formatDataSize(tmpSize, store.getDataSize());
+                        size_t frameCount = store.getFrameCount();
+                        size_t reuseCount = store.getReuseCount();
+                        if (store.close()) {
+                            JCORE_INFO("Exported shared frame store! ({} frames, {} reused references - {})", frameCount, reuseCount, tmpSize);
+                        }
+                    }
                     REPORT_PROGRESS(
                         TaskManager::reportProgress(1, 0.0, 0, materials.size());
                         TaskManager::unregLevel(2);
@@ -425,6 +552,7 @@ namespace Projections {
                     );
 
                 endTask:
+                    panel->getBuffers().store = nullptr;
                     REPORT_PROGRESS(
                         TaskManager::unregLevel(0);
                         TaskManager::unregLevel(1);
@@ -548,6 +676,12 @@ namespace Projections {
             ImGui::Checkbox("P-Materials##EXPORT", exportB + 1);
             ImGui::SameLine();
             ImGui::Checkbox("P-Bundles##EXPORT", exportB + 2);
+            ImGui::SameLine();
+            ImGui::Checkbox("Plan Palettes##EXPORT", &_buffers.settings.planPalettes);
+            ImGui::SameLine();
+            ImGui::Checkbox("Share Frames##EXPORT", &_buffers.settings.sharedFrames);
+            ImGui::SameLine();
+            ImGui::Checkbox("Verify Frames##EXPORT", &_buffers.settings.verifyFused);
 
             {
                 if (_loadedProjections > 0) {
@@ -727,6 +861,59 @@ namespace Projections {
         //}
     }
 
+    // Reads and parses the configs at 'paths' on every core, groups are appended in the order of 'paths'
+    // and failures are reported in that order too. Returns false if loading got cancelled.
+    template<typename T>
+    static bool readGroups(const std::vector<fs::path>& paths, std::vector<T>& groups, size_t& loaded, size_t& total) {
+        REPORT_PROGRESS(
+            TaskManager::reportStep(1, 0.0);
+            TaskManager::reportTarget(2, 0.0, paths.size());
+        );
+
+        size_t start = groups.size();
+        groups.reserve(start + paths.size());
+        for (auto& pth : paths) {
+            groups.emplace_back(pth.string());
+        }
+
+        // Every worker counts what it finished, but only worker 0, the task thread itself,
+        // talks to the TaskManager. Its reports only ever see the count grow.
+        std::vector<uint8_t> results(paths.size(), 0);
+        std::atomic<size_t> done{ 0 };
+        parallelFor(paths.size(), getWorkerCount(), [&groups, &results, &done, start](size_t i, size_t w) {
+            if (TaskManager::isCanceling()) { return; }
+            results[i] = groups[start + i].read() ? 1 : 0;
+            done.fetch_add(1, std::memory_order_relaxed);
+
+            if (w == 0) {
+                REPORT_PROGRESS(
+                    TaskManager::reportProgress(2, double(done.load(std::memory_order_relaxed)));
+                    TaskManager::reportStepFrom(1, 2);
+                );
+            }
+            });
+
+        if (TaskManager::isCanceling()) {
+            return false;
+        }
+
+        REPORT_PROGRESS(
+            TaskManager::reportProgress(2, double(paths.size()));
+            TaskManager::reportStepFrom(1, 2);
+        );
+
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!results[i]) {
+                JCORE_WARN("Failed to load '{}'", groups[start + i].path);
+            }
+            else {
+                loaded++;
+            }
+            total++;
+        }
+        return true;
+    }
+
     void ProjectionGenPanel::load() {
         _isLoaded = false;
         bool* loaded = &_isLoaded;
@@ -744,6 +931,11 @@ namespace Projections {
                 std::vector<fs::path> pathsProj{};
                 std::vector<fs::path> pathsPMat{};
                 std::vector<fs::path> pathsPBun{};
+                std::vector<std::string> roots{};
+                std::vector<const FileIndex::Entry*> files{};
+                std::vector<std::unique_ptr<FileIndex>> indices{};
+                // Projections are read per source but prepared together once every source is read.
+                std::vector<std::pair<Projection*, const FileIndex*>> toPrepare{};
 
                 static constexpr float PERCENT = 1.0f / 3.0f;
                 REPORT_PROGRESS(
@@ -764,6 +956,10 @@ namespace Projections {
                     goto taskEnd;
                 }
 
+                for (auto& keys : _loadedKeys) {
+                    keys.clear();
+                }
+
                 char temp[513]{};
                 for (size_t i = 0; i < _sources.size(); i++) {
                     auto& src = _sources[i];
@@ -788,66 +984,56 @@ namespace Projections {
                         }
                         rootPath = Utils::trimEnd(rootPath, "/\\");
 
-                        sprintf_s(temp, "%.*s", int32_t(rootPath.length()), rootPath.data());
-
-                        size_t left = sizeof(temp) - rootPath.length();
-                        char* namePart = temp + rootPath.length();
+                        // The source is crawled once, config discovery and every prepare of
+                        // its projections list files from the same index.
+                        roots.clear();
                         for (auto& sDir : src.dirs) {
-                            if (TaskManager::isCanceling()) {
-                                goto taskEnd;
-                            }
+                            sprintf_s(temp, "%.*s%.*s", int32_t(rootPath.length()), rootPath.data(),
+                                int32_t(sDir.length() > 1 ? sDir.length() : 0), sDir.data());
+                            roots.emplace_back(temp);
+                            if (sDir.length() < 2) { break; }
+                        }
 
-                            if (sDir.length() > 1) {
-                                sprintf_s(namePart, left, "%.*s", int32_t(sDir.length()), sDir.data());
-                            }
+                        auto& index = *indices.emplace_back(std::make_unique<FileIndex>());
+                        index.build(roots);
+                        if (TaskManager::isCanceling()) {
+                            goto taskEnd;
+                        }
 
-                            if (!IO::getAll(temp, IO::F_TYPE_FILE,
-                                [this, i, &pathsProj, &pathsPMat, &pathsPBun](const fs::path& path)
-                                {
-                                    std::wstring_view pView = path.c_str();
-                                    if (Utils::endsWith(pView, L"P-Data.json") && !this->isAlreadyLoaded(pView, i, ProjectionGenPanel::MODE_PROJECTION)) {
-                                        pathsProj.emplace_back(path);
-                                    }
-                                    else if (Utils::endsWith(pView, L"P-Material.json") && !this->isAlreadyLoaded(pView, i, ProjectionGenPanel::MODE_PMATERIAL)) {
-                                        pathsPMat.emplace_back(path);
-                                    }
-                                    else if (Utils::endsWith(pView, L"P-Bundle.json") && !this->isAlreadyLoaded(pView, i, ProjectionGenPanel::MODE_PBUNDLE)) {
-                                        pathsPBun.emplace_back(path);
-                                    }
-                                }, true)) {
-                                JCORE_WARN("Couldn't find any data json files in '{}'", temp);
+                        for (auto& root : roots) {
+                            files.clear();
+                            if (!index.getFiles(root, files) || files.size() < 1) {
+                                JCORE_WARN("Couldn't find any data json files in '{}'", root);
                                 continue;
                             }
-                            if (sDir.length() < 2) { break; }
+
+                            for (auto file : files) {
+                                std::string_view name = file->getName();
+                                if (name == "P-Data.json" && !this->isAlreadyLoaded(file->path, ProjectionGenPanel::MODE_PROJECTION)) {
+                                    pathsProj.emplace_back(file->path);
+                                }
+                                else if (name == "P-Material.json" && !this->isAlreadyLoaded(file->path, ProjectionGenPanel::MODE_PMATERIAL)) {
+                                    pathsPMat.emplace_back(file->path);
+                                }
+                                else if (name == "P-Bundle.json" && !this->isAlreadyLoaded(file->path, ProjectionGenPanel::MODE_PBUNDLE)) {
+                                    pathsPBun.emplace_back(file->path);
+                                }
+                            }
                         }
 
                         // Projections
                         if (pathsProj.size() > 0) {
                             auto& proj = src.projections;
-                            REPORT_PROGRESS(
-                                TaskManager::reportStep(1, 0.0);
-                                TaskManager::reportTarget(2, 0.0, pathsProj.size());
-                            );
-
-                            proj.reserve(pathsProj.size());
-                            std::string str{};
-                            for (auto& pth : pathsProj) {
-                                if (TaskManager::isCanceling()) {
-                                    goto taskEnd;
-                                }
+                            size_t start = proj.size();
+                            if (!readGroups(pathsProj, proj, *loadPr, src.totalProjections)) {
+                                goto taskEnd;
+                            }
 
-                                str = pth.string();
-                                if (!proj.emplace_back(str).read()) {
-                                    JCORE_WARN("Failed to load '{}'", str);
+                            for (size_t j = start; j < proj.size(); j++) {
+                                if (!proj[j].isValid) { continue; }
+                                for (auto& item : proj[j].projections) {
+                                    toPrepare.emplace_back(&item, indices.back().get());
                                 }
-                                else { 
-                                    (*loadPr)++; 
-                                }
-                                src.totalProjections++;
-                                REPORT_PROGRESS(
-                                    TaskManager::reportIncrement(2);
-                                    TaskManager::reportStepFrom(1, 2);
-                                );
                             }
                             src.isValid |= ProjectionSource::VALID_PROJECTIONS;
                         }
@@ -858,30 +1044,8 @@ namespace Projections {
                         );
 
                         if (pathsPMat.size() > 0) {
-                            auto& mats = src.materials;
-                            REPORT_PROGRESS(
-                                TaskManager::reportStep(1, 0.0);
-                            TaskManager::reportTarget(2, 0.0, pathsPMat.size());
-                            );
-
-                            mats.reserve(pathsPMat.size());
-                            std::string str{};
-                            for (auto& pth : pathsPMat) {
-
-                                if (TaskManager::isCanceling()) {
-                                    goto taskEnd;
-                                }
-
-                                str = pth.string();
-                                if (!mats.emplace_back(str).read()) {
-                                    JCORE_WARN("Failed to load '{}'", str);
-                                }
-                                else { (*loadMt)++; }
-                                src.totalMaterials++;
-                                REPORT_PROGRESS(
-                                    TaskManager::reportIncrement(2);
-                                TaskManager::reportStepFrom(1, 2);
-                                );
+                            if (!readGroups(pathsPMat, src.materials, *loadMt, src.totalMaterials)) {
+                                goto taskEnd;
                             }
                             src.isValid |= ProjectionSource::VALID_MATERIALS;
                         }
@@ -892,30 +1056,8 @@ namespace Projections {
                         );
 
                         if (pathsPBun.size() > 0) {
-                            auto& buns = src.bundles;
-                            REPORT_PROGRESS(
-                                TaskManager::reportStep(1, 0.0);
-                            TaskManager::reportTarget(2, 0.0, pathsPBun.size());
-                            );
-
-                            buns.reserve(pathsPBun.size());
-                            std::string str{};
-                            for (auto& pth : pathsPBun) {
-
-                                if (TaskManager::isCanceling()) {
-                                    goto taskEnd;
-                                }
-
-                                str = pth.string();
-                                if (!buns.emplace_back(str).read()) {
-                                    JCORE_WARN("Failed to load '{}'", str);
-                                }
-                                else { (*loadBu)++; }
-                                src.totalBundles++;
-                                REPORT_PROGRESS(
-                                    TaskManager::reportIncrement(2);
-                                TaskManager::reportStepFrom(1, 2);
-                                );
+                            if (!readGroups(pathsPBun, src.bundles, *loadBu, src.totalBundles)) {
+                                goto taskEnd;
                             }
                             src.isValid |= ProjectionSource::VALID_BUNDLES;
                         }
@@ -941,12 +1083,44 @@ namespace Projections {
                         }
                     }
 
+                    addLoadedKeys(src);
+
                     REPORT_PROGRESS(
                         TaskManager::reportIncrement(0);
                     TaskManager::reportProgress(1, 0.0, 0.0, 3.0);
                     TaskManager::reportProgress(2, 0.0, 0.0, 0.0);
                     );
                 }
+
+                if (toPrepare.size() > 0) {
+                    REPORT_PROGRESS(
+                        TaskManager::report(1, "Preparing %zu Projections...", toPrepare.size());
+                    );
+
+                    // Stdin is read here once and kept for every later prepare,
+                    // so no worker ends up blocked on it.
+                    for (auto& item : toPrepare) {
+                        if (item.first->usesStdin()) {
+                            spoolStdin();
+                            break;
+                        }
+                    }
+
+                    // Prepare is mostly directory walks and header reads, so it's spread over
+                    // every projection of every source instead of being run one at a time.
+                    parallelFor(toPrepare.size(), getWorkerCount(), [&toPrepare](size_t i, size_t) {
+                        if (TaskManager::isCanceling()) { return; }
+
+                        auto& proj = *toPrepare[i].first;
+                        if (!proj.prepare(toPrepare[i].second)) {
+                            JCORE_WARN("Failed to prepare Projection {}", proj.material.nameID);
+                        }
+                        });
+
+                    if (TaskManager::isCanceling()) {
+                        goto taskEnd;
+                    }
+                }
                 *loaded = true;
 
             taskEnd:
@@ -984,12 +1158,7 @@ namespace Projections {
                         for (size_t i = 0; i < pArr.size(); i++) {
                             if (pArr[i].is_object()) {
                                 auto& proj = projections.emplace_back();
-                                if (proj.read(pArr[i], path)) {
-                                    if (!proj.prepare()) {
-                                        JCORE_WARN("Failed to prepare Projection {}", proj.material.nameID);
-                                    }
-                                }
-                                else {
+                                if (!proj.read(pArr[i], path)) {
                                     JCORE_WARN("Failed to read Projection #{} in {}", i, path);
                                 }
                             }
@@ -0,0 +1,157 @@
+#include <RawStream.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <J-Core/IO/IOUtils.h>
+#include <J-Core/IO/FileStream.h>
+#include <J-Core/Math/Math.h>
+#include <J-Core/Log.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+using namespace JCore;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace Projections {
+    // Spool file of stdin, removed when the process exits.
+    struct StdinSpool {
+        std::string path{};
+        bool isRead{};
+
+        ~StdinSpool() {
+            if (path.length() > 0) {
+                std::error_code err{};
+                fs::remove(path, err);
+            }
+        }
+    };
+    static StdinSpool stdinSpool{};
+
+    bool spoolStdin() {
+        if (stdinSpool.isRead) { return stdinSpool.path.length() > 0; }
+        stdinSpool.isRead = true;
+
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+        std::error_code err{};
+        fs::path dir = fs::temp_directory_path(err);
+        if (err) {
+            JCORE_ERROR("Failed to spool stdin, no temporary directory!");
+            return false;
+        }
+        // Ticks keep concurrent runs from sharing a spool file.
+        auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::string spool = (dir / ("Projections_stdin_" + std::to_string(ticks) + ".raw")).string();
+
+        FileStream fs{};
+        if (!fs.open(spool, "wb")) {
+            JCORE_ERROR("Failed to spool stdin into '{}'!", spool);
+            return false;
+        }
+
+        static constexpr size_t CHUNK_SIZE = 1 << 20;
+        std::vector<uint8_t> chunk(CHUNK_SIZE);
+        size_t total = 0;
+        for (;;) {
+            size_t read = fread(chunk.data(), 1, CHUNK_SIZE, stdin);
+            if (read < 1) { break; }
+            fs.write(chunk.data(), read, false);
+            total += read;
+        }
+        fs.close();
+
+        stdinSpool.path = spool;
+        JCORE_TRACE("Spooled {} bytes of stdin", total);
+        return true;
+    }
+
+    StreamSource::StreamSource(std::string_view path, int32_t width, int32_t height) :
+        _path(path), _width(width), _height(height) {}
+
+    bool StreamSource::open(std::string_view root, size_t maxFrames) {
+        close();
+        if (_width < 1 || _height < 1) { return false; }
+
+        std::string path{};
+        if (_path == "-") {
+            if (stdinSpool.path.length() < 1) {
+                JCORE_ERROR("Stdin has to be spooled before a raw stream can read it!");
+                return false;
+            }
+            path = stdinSpool.path;
+        }
+        else {
+            path = IO::combine(root, _path);
+        }
+
+        // Frames are read in any order by the workers, so no sequential hint.
+        if (!_file.open(path, false)) {
+            JCORE_ERROR("Failed to open raw stream '{}'!", path);
+            close();
+            return false;
+        }
+
+        const size_t frameBytes = size_t(_width) * _height * sizeof(Color32);
+        _frameCount = _file.size() / frameBytes;
+        if (maxFrames > 0) {
+            _frameCount = Math::min(_frameCount, maxFrames);
+        }
+
+        if (_file.size() % frameBytes != 0 && (maxFrames < 1 || _frameCount < maxFrames)) {
+            JCORE_WARN("Raw stream '{}' ends in a partial frame, it will be ignored", _path);
+        }
+        return _frameCount > 0;
+    }
+
+    void StreamSource::close() {
+        _file.close();
+        _frameCount = 0;
+    }
+
+    bool StreamSource::readFrame(size_t frame, ImageData& img) const {
+        if (frame >= _frameCount || !img.doAllocate(_width, _height, TextureFormat::RGBA32)) { return false; }
+
+        const size_t frameBytes = size_t(_width) * _height * sizeof(Color32);
+        memcpy(img.data, _file.data() + frame * frameBytes, frameBytes);
+        return true;
+    }
+
+    void RawStream::reset() {
+        path.clear();
+        layer = 0;
+        emission = false;
+        startFrame = 0;
+        width = 0;
+        height = 0;
+        frameCount = 0;
+    }
+
+    void RawStream::read(const json& jsonF) {
+        reset();
+        if (jsonF.is_object()) {
+            path = jsonF.value("path", std::string{});
+            layer = Math::max(jsonF.value("layer", 0), 0);
+            emission = jsonF.value("emission", false);
+            startFrame = Math::max(jsonF.value("startFrame", 0), 0);
+            width = Math::max(jsonF.value("width", 0), 0);
+            height = Math::max(jsonF.value("height", 0), 0);
+            frameCount = Math::max(jsonF.value("frameCount", 0), 0);
+        }
+    }
+
+    void RawStream::write(json& jsonF) const {
+        jsonF["path"] = path;
+        jsonF["layer"] = layer;
+        jsonF["emission"] = emission;
+        jsonF["startFrame"] = startFrame;
+        jsonF["width"] = width;
+        jsonF["height"] = height;
+        jsonF["frameCount"] = frameCount;
+    }
+}
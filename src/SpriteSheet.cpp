@@ -0,0 +1,246 @@
+#include <SpriteSheet.h>
+#include <MappedImage.h>
+#include <cstring>
+#include <J-Core/IO/IOUtils.h>
+#include <J-Core/IO/FileStream.h>
+#include <J-Core/Math/Math.h>
+#include <J-Core/Log.h>
+using namespace JCore;
+using json = nlohmann::json;
+
+namespace Projections {
+    SheetSource::SheetSource(std::string_view path) : _path(path), _format(getImageFormat(path)) {}
+
+    bool SheetSource::load(std::string_view root) {
+        std::string path = IO::combine(root, _path);
+        ImageData decoded{};
+        if (!decodeImageFile(path, _format, decoded)) {
+            JCORE_ERROR("Failed to decode sprite sheet '{}'!", path);
+            return false;
+        }
+
+        // Sheets are kept as RGBA32 so slicing is a plain row copy.
+        bool valid = _image.doAllocate(decoded.width, decoded.height, TextureFormat::RGBA32);
+        if (valid) {
+            size_t reso = size_t(decoded.width) * decoded.height;
+            if (decoded.format == TextureFormat::RGBA32) {
+                memcpy(_image.data, decoded.getData(), reso * sizeof(Color32));
+            }
+            else {
+                Color32* pixels = reinterpret_cast<Color32*>(_image.data);
+                const uint8_t* dataPos = decoded.getData();
+                size_t bpp = getBitsPerPixel(decoded.format) >> 3;
+                for (size_t i = 0; i < reso; i++) {
+                    convertPixel(decoded.format, decoded.data, dataPos, pixels[i]);
+                    dataPos += bpp;
+                }
+            }
+        }
+        decoded.clear(true);
+        return valid;
+    }
+
+    bool SheetSource::slice(const SheetRect& rect, std::string_view root, ImageData& img) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_loaded && !_failed) {
+                _loaded = load(root);
+                _failed = !_loaded;
+            }
+            if (!_loaded) { return false; }
+        }
+
+        if (rect.x < 0 || rect.y < 0 || rect.width < 1 || rect.height < 1 ||
+            rect.x + rect.width > _image.width || rect.y + rect.height > _image.height) {
+            return false;
+        }
+
+        if (!img.doAllocate(rect.width, rect.height, TextureFormat::RGBA32)) { return false; }
+
+        const size_t rowBytes = size_t(rect.width) * sizeof(Color32);
+        const size_t sheetStride = size_t(_image.width) * sizeof(Color32);
+        const uint8_t* src = _image.data + size_t(rect.y) * sheetStride + size_t(rect.x) * sizeof(Color32);
+        uint8_t* dst = img.data;
+        for (int32_t y = 0; y < rect.height; y++, src += sheetStride, dst += rowBytes) {
+            memcpy(dst, src, rowBytes);
+        }
+        return true;
+    }
+
+    void SheetSource::release() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _image.clear(true);
+        _loaded = false;
+        _failed = false;
+    }
+
+    void SpriteSheet::reset() {
+        path.clear();
+        atlas.clear();
+        layer = 0;
+        emission = false;
+        startFrame = 0;
+        frameWidth = 0;
+        frameHeight = 0;
+        columns = 0;
+        frameCount = 0;
+        spacing = 0;
+    }
+
+    void SpriteSheet::read(const json& jsonF) {
+        reset();
+        if (jsonF.is_object()) {
+            path = jsonF.value("path", std::string{});
+            atlas = jsonF.value("atlas", std::string{});
+            layer = Math::max(jsonF.value("layer", 0), 0);
+            emission = jsonF.value("emission", false);
+            startFrame = Math::max(jsonF.value("startFrame", 0), 0);
+            frameWidth = Math::max(jsonF.value("frameWidth", 0), 0);
+            frameHeight = Math::max(jsonF.value("frameHeight", 0), 0);
+            columns = Math::max(jsonF.value("columns", 0), 0);
+            frameCount = Math::max(jsonF.value("frameCount", 0), 0);
+            spacing = Math::max(jsonF.value("spacing", 0), 0);
+        }
+    }
+
+    void SpriteSheet::write(json& jsonF) const {
+        jsonF["path"] = path;
+        if (atlas.length() > 0) {
+            jsonF["atlas"] = atlas;
+        }
+        jsonF["layer"] = layer;
+        jsonF["emission"] = emission;
+        jsonF["startFrame"] = startFrame;
+        jsonF["frameWidth"] = frameWidth;
+        jsonF["frameHeight"] = frameHeight;
+        jsonF["columns"] = columns;
+        jsonF["frameCount"] = frameCount;
+        jsonF["spacing"] = spacing;
+    }
+
+    // Atlases are parsed into an ordered_json, object keyed atlases then keep the order of the file.
+    using atlas_json = nlohmann::ordered_json;
+
+    // Reads an integer field, missing, non-integer and out of range fields give 'fallback'.
+    // 'value' would throw on a field of the wrong type, and atlases are read on prepare workers.
+    static int32_t readAtlasInt(const atlas_json& src, const char* key, int32_t fallback) {
+        auto it = src.find(key);
+        if (it == src.end() || !it->is_number_integer()) { return fallback; }
+
+        int64_t value = it->is_number_unsigned() ? int64_t(Math::min<uint64_t>(it->get<uint64_t>(), INT64_MAX)) : it->get<int64_t>();
+        return value >= INT32_MIN && value <= INT32_MAX ? int32_t(value) : fallback;
+    }
+
+    // Accepts both a plain array of rectangles and the hash/array layouts common atlas
+    // packers write, where each entry keeps its rectangle under "frame".
+    static bool readAtlasRect(const atlas_json& entry, SheetRect& rect) {
+        if (!entry.is_object()) { return false; }
+
+        auto rotated = entry.find("rotated");
+        if (rotated != entry.end() && rotated->is_boolean() && rotated->get<bool>()) { return false; }
+
+        auto frame = entry.find("frame");
+        const atlas_json& src = frame != entry.end() && frame->is_object() ? *frame : entry;
+        rect.x = readAtlasInt(src, "x", -1);
+        rect.y = readAtlasInt(src, "y", -1);
+        rect.width = readAtlasInt(src, "w", readAtlasInt(src, "width", 0));
+        rect.height = readAtlasInt(src, "h", readAtlasInt(src, "height", 0));
+        return rect.x >= 0 && rect.y >= 0 && rect.width > 0 && rect.height > 0;
+    }
+
+    static bool readAtlas(const std::string& path, std::vector<SheetRect>& cells) {
+        FileStream fs{};
+        if (!fs.open(path, "rb")) { return false; }
+
+        std::vector<char> text(fs.size());
+        fs.read(text.data(), text.size(), 1);
+        fs.close();
+
+        atlas_json jsonF = atlas_json::parse(text.begin(), text.end(), nullptr, false, true);
+        const atlas_json* frames = &jsonF;
+        if (jsonF.is_object()) {
+            if (!jsonF.contains("frames")) { return false; }
+            frames = &jsonF["frames"];
+        }
+
+        // Object keyed atlases are taken in the order their keys appear in the file.
+        SheetRect rect{};
+        if (frames->is_array() || frames->is_object()) {
+            for (auto& entry : *frames) {
+                if (!readAtlasRect(entry, rect)) {
+                    JCORE_WARN("Skipping invalid or rotated atlas entry #{} in '{}'", cells.size(), path);
+                    rect = SheetRect{};
+                }
+                cells.push_back(rect);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Frame indices only have 23 bits, see PFrameIndex, a sheet can't fill more frames than that.
+    static constexpr int64_t MAX_CELLS = 0x800000;
+
+    bool SpriteSheet::getCells(std::string_view root, std::vector<SheetRect>& cells) const {
+        cells.clear();
+        if (path.length() < 1) { return false; }
+
+        ImageData info{};
+        std::string sheetPath = IO::combine(root, path);
+        if (!getImageFileInfo(sheetPath, getImageFormat(path), info)) {
+            JCORE_WARN("Failed to read sprite sheet '{}'!", sheetPath);
+            return false;
+        }
+
+        size_t dropped = 0;
+        if (atlas.length() > 0) {
+            std::string atlasPath = IO::combine(root, atlas);
+            if (!readAtlas(atlasPath, cells)) {
+                JCORE_WARN("Failed to read sprite atlas '{}'!", atlasPath);
+                return false;
+            }
+        }
+        else {
+            if (frameWidth < 1 || frameHeight < 1) {
+                JCORE_WARN("Sprite sheet '{}' has no frame size!", path);
+                return false;
+            }
+
+            // The grid is worked out in 64-bit, large 'columns' or 'spacing' would overflow it otherwise.
+            int64_t stepX = int64_t(frameWidth) + spacing;
+            int64_t stepY = int64_t(frameHeight) + spacing;
+            int64_t cols = columns > 0 ? columns : (int64_t(info.width) + spacing) / stepX;
+            int64_t rows = (int64_t(info.height) + spacing) / stepY;
+            int64_t count = Math::min<int64_t>(cols * rows, MAX_CELLS);
+            if (frameCount > 0) {
+                count = Math::min<int64_t>(count, frameCount);
+            }
+            if (cols < 1 || count < 1) { return false; }
+
+            // Cells past the edge of the sheet stay as empty ones, so the cells after them keep their frames.
+            cells.reserve(size_t(count));
+            for (int64_t i = 0; i < count; i++) {
+                int64_t x = (i % cols) * stepX;
+                int64_t y = (i / cols) * stepY;
+                if (x + frameWidth > info.width || y + frameHeight > info.height) {
+                    cells.emplace_back();
+                    dropped++;
+                    continue;
+                }
+                cells.push_back(SheetRect{ int32_t(x), int32_t(y), frameWidth, frameHeight });
+            }
+        }
+
+        for (auto& cell : cells) {
+            if (cell.width > 0 && (cell.x < 0 || cell.y < 0 ||
+                int64_t(cell.x) + cell.width > info.width || int64_t(cell.y) + cell.height > info.height)) {
+                cell = SheetRect{};
+                dropped++;
+            }
+        }
+        if (dropped > 0) {
+            JCORE_WARN("Dropped {} cells outside of sprite sheet '{}' ({}x{})", dropped, path, info.width, info.height);
+        }
+        return cells.size() > 0;
+    }
+}
@@ -0,0 +1,228 @@
+#include <ZipArchive.h>
+#include <cstring>
+#include <zlib.h>
+#include <J-Core/Log.h>
+using namespace JCore;
+
+namespace Projections {
+    static constexpr uint32_t SIG_LOCAL = 0x04034B50U;
+    static constexpr uint32_t SIG_CENTRAL = 0x02014B50U;
+    static constexpr uint32_t SIG_EOCD = 0x06054B50U;
+    static constexpr uint32_t SIG_EOCD64 = 0x06064B50U;
+    static constexpr uint32_t SIG_EOCD64_LOCATOR = 0x07064B50U;
+
+    static constexpr uint16_t METHOD_STORED = 0;
+    static constexpr uint16_t METHOD_DEFLATE = 8;
+    static constexpr uint16_t FLAG_ENCRYPTED = 0x1;
+
+    // Guards against corrupt headers asking for absurd allocations.
+    static constexpr uint64_t MAX_ENTRY_SIZE = uint64_t(1) << 30;
+
+    template<typename T>
+    static inline T readAt(const uint8_t* data, size_t offset) {
+        T value;
+        memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    bool ZipArchive::open(const std::string& path) {
+        close();
+        if (!_file.open(path, false)) { return false; }
+
+        _path = path;
+        if (!readCentralDirectory()) {
+            JCORE_WARN("Failed to read the central directory of '{}'!", path);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void ZipArchive::close() {
+        _lookup.clear();
+        _entries.clear();
+        _file.close();
+        _path.clear();
+    }
+
+    size_t ZipArchive::find(std::string_view name) const {
+        auto it = _lookup.find(name);
+        return it != _lookup.end() ? it->second : SIZE_MAX;
+    }
+
+    bool ZipArchive::readCentralDirectory() {
+        const uint8_t* data = _file.data();
+        const size_t size = _file.size();
+        if (size < 22) { return false; }
+
+        // The end of central directory record sits behind an optional comment of up to 64 KB.
+        size_t eocd = SIZE_MAX;
+        size_t lowest = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+        for (size_t i = size - 22 + 1; i-- > lowest;) {
+            if (readAt<uint32_t>(data, i) == SIG_EOCD) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd == SIZE_MAX) { return false; }
+
+        uint64_t count = readAt<uint16_t>(data, eocd + 10);
+        uint64_t dirSize = readAt<uint32_t>(data, eocd + 12);
+        uint64_t dirOffset = readAt<uint32_t>(data, eocd + 16);
+
+        if (count == 0xFFFF || dirSize == 0xFFFFFFFFU || dirOffset == 0xFFFFFFFFU) {
+            if (eocd < 20 || readAt<uint32_t>(data, eocd - 20) != SIG_EOCD64_LOCATOR) { return false; }
+            uint64_t eocd64 = readAt<uint64_t>(data, eocd - 20 + 8);
+            if (size < 56 || eocd64 > size - 56 || readAt<uint32_t>(data, size_t(eocd64)) != SIG_EOCD64) { return false; }
+
+            count = readAt<uint64_t>(data, size_t(eocd64) + 32);
+            dirSize = readAt<uint64_t>(data, size_t(eocd64) + 40);
+            dirOffset = readAt<uint64_t>(data, size_t(eocd64) + 48);
+        }
+        if (dirOffset > size || dirSize > size - dirOffset || count > dirSize / 46) { return false; }
+
+        _entries.reserve(size_t(count));
+        const uint8_t* pos = data + dirOffset;
+        const uint8_t* end = pos + dirSize;
+        for (uint64_t i = 0; i < count; i++) {
+            if (end - pos < 46 || readAt<uint32_t>(pos, 0) != SIG_CENTRAL) { return false; }
+
+            uint16_t nameLen = readAt<uint16_t>(pos, 28);
+            uint16_t extraLen = readAt<uint16_t>(pos, 30);
+            uint16_t commentLen = readAt<uint16_t>(pos, 32);
+            size_t recordSize = size_t(46) + nameLen + extraLen + commentLen;
+            if (size_t(end - pos) < recordSize) { return false; }
+
+            Entry entry{};
+            entry.flags = readAt<uint16_t>(pos, 8);
+            entry.method = readAt<uint16_t>(pos, 10);
+            entry.crc = readAt<uint32_t>(pos, 16);
+            entry.compressedSize = readAt<uint32_t>(pos, 20);
+            entry.size = readAt<uint32_t>(pos, 24);
+            entry.localOffset = readAt<uint32_t>(pos, 42);
+            entry.name.assign(reinterpret_cast<const char*>(pos + 46), nameLen);
+
+            // ZIP64 extra field, only holds the values that overflowed in the record itself.
+            const uint8_t* extra = pos + 46 + nameLen;
+            const uint8_t* extraEnd = extra + extraLen;
+            while (extraEnd - extra >= 4) {
+                uint16_t id = readAt<uint16_t>(extra, 0);
+                uint16_t len = readAt<uint16_t>(extra, 2);
+                if (size_t(extraEnd - extra - 4) < len) { break; }
+
+                if (id == 0x0001) {
+                    const uint8_t* field = extra + 4;
+                    const uint8_t* fieldEnd = field + len;
+                    auto readWide = [&](uint64_t& value) {
+                        if (value == 0xFFFFFFFFU && fieldEnd - field >= 8) {
+                            value = readAt<uint64_t>(field, 0);
+                            field += 8;
+                        }
+                    };
+                    readWide(entry.size);
+                    readWide(entry.compressedSize);
+                    readWide(entry.localOffset);
+                }
+                extra += 4 + len;
+            }
+
+            pos += recordSize;
+            if (entry.name.empty() || entry.name.back() == '/') { continue; }
+            _entries.emplace_back(std::move(entry));
+        }
+
+        // Names are only viewed once the entry list won't move anymore.
+        _lookup.reserve(_entries.size());
+        for (size_t i = 0; i < _entries.size(); i++) {
+            _lookup.emplace(std::string_view(_entries[i].name), i);
+        }
+        return true;
+    }
+
+    const uint8_t* ZipArchive::getEntryData(const Entry& entry) const {
+        if ((entry.flags & FLAG_ENCRYPTED) || entry.size > MAX_ENTRY_SIZE || entry.compressedSize > MAX_ENTRY_SIZE) { return nullptr; }
+
+        const uint8_t* file = _file.data();
+        const size_t fileSize = _file.size();
+        if (entry.localOffset > fileSize || fileSize - entry.localOffset < 30) { return nullptr; }
+
+        const uint8_t* local = file + entry.localOffset;
+        if (readAt<uint32_t>(local, 0) != SIG_LOCAL) { return nullptr; }
+
+        // The local header's name and extra field lengths can differ from the central directory's.
+        uint64_t dataOffset = entry.localOffset + 30 + readAt<uint16_t>(local, 26) + readAt<uint16_t>(local, 28);
+        if (dataOffset > fileSize || fileSize - dataOffset < entry.compressedSize) { return nullptr; }
+        return file + dataOffset;
+    }
+
+    bool ZipArchive::read(size_t index, std::vector<uint8_t>& data) const {
+        if (index >= _entries.size()) { return false; }
+
+        const Entry& entry = _entries[index];
+        const uint8_t* src = getEntryData(entry);
+        if (!src) { return false; }
+
+        data.resize(size_t(entry.size));
+        switch (entry.method) {
+            case METHOD_STORED:
+                if (entry.compressedSize != entry.size) { return false; }
+                memcpy(data.data(), src, size_t(entry.size));
+                break;
+            case METHOD_DEFLATE: {
+                z_stream stream{};
+                if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) { return false; }
+
+                stream.next_in = const_cast<Bytef*>(src);
+                stream.avail_in = uInt(entry.compressedSize);
+                stream.next_out = data.data();
+                stream.avail_out = uInt(entry.size);
+                int result = inflate(&stream, Z_FINISH);
+                uint64_t written = stream.total_out;
+                inflateEnd(&stream);
+
+                if (result != Z_STREAM_END || written != entry.size) { return false; }
+                break;
+            }
+            default:
+                return false;
+        }
+
+        return uint32_t(crc32(0L, data.data(), uInt(data.size()))) == entry.crc;
+    }
+
+    bool ZipArchive::readPrefix(size_t index, size_t maxSize, std::vector<uint8_t>& data) const {
+        if (index >= _entries.size()) { return false; }
+
+        const Entry& entry = _entries[index];
+        const uint8_t* src = getEntryData(entry);
+        if (!src) { return false; }
+
+        size_t size = entry.size < maxSize ? size_t(entry.size) : maxSize;
+        data.resize(size);
+        if (size < 1) { return true; }
+
+        switch (entry.method) {
+            case METHOD_STORED:
+                if (entry.compressedSize != entry.size) { return false; }
+                memcpy(data.data(), src, size);
+                return true;
+            case METHOD_DEFLATE: {
+                z_stream stream{};
+                if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) { return false; }
+
+                // Inflate stops as soon as the output is full, the rest of the entry is never touched.
+                stream.next_in = const_cast<Bytef*>(src);
+                stream.avail_in = uInt(entry.compressedSize);
+                stream.next_out = data.data();
+                stream.avail_out = uInt(size);
+                int result = inflate(&stream, Z_SYNC_FLUSH);
+                uint64_t written = stream.total_out;
+                inflateEnd(&stream);
+
+                return (result == Z_OK || result == Z_STREAM_END || result == Z_BUF_ERROR) && written == size;
+            }
+            default:
+                return false;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include <FrameHash.h>
+#include <TestUtils.h>
+#include <J-Core/Util/DataUtils.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+using namespace Projections;
+using Tests::timeBest;
+
+// Throughput of the per-block CRC32 that FrameHash replaced, and of FrameHash on its scalar
+// slicing-by-8 path and on the SSE4.2 path, over a frame sized buffer that stays in cache
+// and a large one that doesn't.
+namespace {
+    constexpr int32_t RUNS = 7;
+
+    // The old CRCBlocks scheme, eight J-Core CRC32s in a row over equal blocks of the frame.
+    void hashBlocks(uint32_t* crcs, const uint8_t* data, size_t size) {
+        size_t chunkSize = std::max<size_t>(size >> 3, 1);
+        for (size_t i = 0; i < 8 && size > 0; i++) {
+            size_t len = std::min(size, chunkSize);
+            crcs[i] = JCore::Data::calcuateCRC(data, len);
+            data += len;
+            size -= len;
+        }
+    }
+
+    void runCase(const char* name, size_t size) {
+        std::mt19937 rng(0x32B);
+        std::vector<uint8_t> data(size);
+        for (auto& value : data) {
+            value = uint8_t(rng());
+        }
+
+        uint32_t crcs[8]{ 0 };
+        double blocksTime = timeBest(RUNS, [&]() {
+            hashBlocks(crcs, data.data(), data.size());
+            });
+
+        FrameHash scalar{}, dispatched{};
+        double scalarTime = timeBest(RUNS, [&]() {
+            scalar.clear();
+            scalar.updateScalar(data.data(), data.size());
+            });
+        double dispatchedTime = timeBest(RUNS, [&]() {
+            dispatched.clear();
+            dispatched.update(data.data(), data.size());
+            });
+
+        printf("%-6s %9zu bytes, blocks: %6.2f GB/s, scalar: %6.2f GB/s, %s: %6.2f GB/s%s\n",
+            name, size,
+            size / blocksTime * 1e-9,
+            size / scalarTime * 1e-9,
+            FrameHash::hasHardwareCRC() ? "SSE4.2" : "scalar", size / dispatchedTime * 1e-9,
+            scalar == dispatched ? "" : " (MISMATCH)");
+    }
+}
+
+int main() {
+    runCase("cached", 256 * 256 * 4);
+    runCase("large", 2048 * 2048 * 4 * 8);
+    return 0;
+}
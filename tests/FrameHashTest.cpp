@@ -0,0 +1,128 @@
+#include <FrameHash.h>
+#include <TestUtils.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+using namespace Projections;
+
+// Known answer checks of the CRC32C lanes on both the scalar and the SSE4.2 path.
+namespace {
+    // Bit at a time CRC32C, slow but too simple to get wrong.
+    uint32_t referenceCRC(uint32_t crc, const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            crc ^= data[i];
+            for (int32_t j = 0; j < 8; j++) {
+                crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 0x1)));
+            }
+        }
+        return crc;
+    }
+
+    // Splits 'data' into lanes the way FrameHash does: 8 byte words round robin over
+    // the lanes, the words past the last full stripe and then the leftover bytes go to
+    // the lanes in order. Lanes start at zero with no final xor.
+    void referenceLanes(const uint8_t* data, size_t size, uint32_t* lanes) {
+        for (size_t i = 0; i < FrameHash::LANES; i++) {
+            lanes[i] = 0;
+        }
+
+        size_t stripes = size / FrameHash::STRIDE;
+        for (size_t i = 0; i < stripes * FrameHash::LANES; i++) {
+            lanes[i % FrameHash::LANES] = referenceCRC(lanes[i % FrameHash::LANES], data + i * 8, 8);
+        }
+
+        size_t pos = stripes * FrameHash::STRIDE;
+        size_t lane = 0;
+        for (; size - pos >= 8; pos += 8, lane++) {
+            lanes[lane] = referenceCRC(lanes[lane], data + pos, 8);
+        }
+        lanes[lane] = referenceCRC(lanes[lane], data + pos, size - pos);
+    }
+
+    bool sameLanes(const FrameHash& hash, const uint32_t* lanes) {
+        for (size_t i = 0; i < FrameHash::LANES; i++) {
+            if (hash.lanes[i] != lanes[i]) { return false; }
+        }
+        return true;
+    }
+}
+
+int main() {
+    // The published CRC32C check value, with the usual ~0 start and final xor.
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    PROJ_CHECK((referenceCRC(~0U, check, sizeof(check)) ^ ~0U) == 0xE3069283U);
+
+    // A lane seeded with ~0 has to reproduce it on both paths. Every call starts at lane 0,
+    // so the word "12345678" and then the byte '9' both go to the first lane.
+    FrameHash scalarCheck{}, dispatchedCheck{};
+    scalarCheck.lanes[0] = ~0U;
+    scalarCheck.updateScalar(check, 8);
+    scalarCheck.updateScalar(check + 8, 1);
+    PROJ_CHECK((scalarCheck.lanes[0] ^ ~0U) == 0xE3069283U);
+
+    dispatchedCheck.lanes[0] = ~0U;
+    dispatchedCheck.update(check, 8);
+    dispatchedCheck.update(check + 8, 1);
+    PROJ_CHECK((dispatchedCheck.lanes[0] ^ ~0U) == 0xE3069283U);
+
+    std::mt19937 rng(0x32C);
+    std::vector<uint8_t> data(4096 + 37);
+    for (auto& value : data) {
+        value = uint8_t(rng());
+    }
+
+    const bool hasHardware = FrameHash::hasHardwareCRC();
+    if (!hasHardware) {
+        printf("No SSE4.2, only the scalar path is checked\n");
+    }
+
+    // Every length up to a few stripes covers all tail shapes, then a few longer ones.
+    std::vector<size_t> sizes{};
+    for (size_t i = 0; i <= FrameHash::STRIDE * 3; i++) {
+        sizes.push_back(i);
+    }
+    sizes.push_back(1024);
+    sizes.push_back(4096 + 37);
+
+    for (size_t size : sizes) {
+        uint32_t expected[FrameHash::LANES]{};
+        referenceLanes(data.data(), size, expected);
+
+        FrameHash scalar{};
+        scalar.updateScalar(data.data(), size);
+        PROJ_CHECK(sameLanes(scalar, expected));
+
+        FrameHash dispatched{};
+        dispatched.update(data.data(), size);
+        PROJ_CHECK(sameLanes(dispatched, expected));
+        PROJ_CHECK(dispatched == scalar);
+
+        // Streamed in whole stripes, the last call taking the rest.
+        FrameHash streamed{};
+        size_t split = (size / 2) / FrameHash::STRIDE * FrameHash::STRIDE;
+        streamed.update(data.data(), split);
+        streamed.update(data.data() + split, size - split);
+        PROJ_CHECK(streamed == dispatched);
+    }
+
+    // Zeroes hash to zero, any set bit doesn't.
+    std::vector<uint8_t> zeroes(4096, 0);
+    FrameHash zero{};
+    PROJ_CHECK(!zero.from(zeroes.data(), zeroes.size()));
+    PROJ_CHECK(zero.isZero() && zero.getKey() == 0);
+
+    zeroes[4000] = 1;
+    FrameHash single{};
+    PROJ_CHECK(single.from(zeroes.data(), zeroes.size()));
+    PROJ_CHECK(single != zero);
+
+    // Swapping two words of the same lane changes the hash.
+    std::vector<uint8_t> swapped(data.begin(), data.begin() + 1024);
+    std::swap_ranges(swapped.begin(), swapped.begin() + 8, swapped.begin() + FrameHash::STRIDE);
+    FrameHash original{}, reordered{};
+    original.from(data.data(), 1024);
+    reordered.from(swapped.data(), swapped.size());
+    PROJ_CHECK(original != reordered);
+
+    return Tests::finish("FrameHashTest");
+}
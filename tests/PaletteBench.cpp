@@ -0,0 +1,94 @@
+#include <ProjectionGen.h>
+#include <TestUtils.h>
+#include <memory>
+#include <random>
+using namespace Projections;
+using namespace JCore;
+using Tests::timeBest;
+
+// Times Palette::add, with its last hit and direct mapped cache, against plain
+// table lookups on frames shaped like typical projection frames.
+namespace {
+    constexpr int32_t FRAME_SIZE = 512 * 512;
+    constexpr int32_t RUNS = 5;
+
+    Color32 toColor(uint32_t value) {
+        return reinterpret_cast<const Color32&>(value);
+    }
+
+    // Long runs of a handful of colors, like flat shaded sprites.
+    void makeRuns(std::vector<Color32>& pixels, std::mt19937& rng) {
+        uint32_t colors[16]{};
+        for (auto& color : colors) {
+            color = rng() | 0xFF000000U;
+        }
+
+        for (size_t i = 0; i < pixels.size();) {
+            size_t len = 1 + rng() % 48;
+            Color32 color = toColor(colors[rng() % 16]);
+            for (; len > 0 && i < pixels.size(); len--, i++) {
+                pixels[i] = color;
+            }
+        }
+    }
+
+    // Short runs over a few thousand colors, like dithered or noisy frames.
+    void makeNoise(std::vector<Color32>& pixels, std::mt19937& rng) {
+        std::vector<uint32_t> colors(4096);
+        for (auto& color : colors) {
+            color = rng() | 0xFF000000U;
+        }
+
+        for (size_t i = 0; i < pixels.size();) {
+            size_t len = 1 + rng() % 3;
+            Color32 color = toColor(colors[rng() % colors.size()]);
+            for (; len > 0 && i < pixels.size(); len--, i++) {
+                pixels[i] = color;
+            }
+        }
+    }
+
+    // Every pixel a new color until the palette is full.
+    void makeUnique(std::vector<Color32>& pixels, std::mt19937& rng) {
+        for (auto& pixel : pixels) {
+            pixel = toColor(rng());
+        }
+    }
+
+    void runCase(const char* name, void(*generate)(std::vector<Color32>&, std::mt19937&)) {
+        std::mt19937 rng(0x5EED);
+        std::vector<Color32> pixels(FRAME_SIZE);
+        generate(pixels, rng);
+
+        // The palette is a few hundred KB, keep it off the stack.
+        auto palette = std::make_unique<Palette>();
+        int64_t checksum = 0;
+
+        double addTime = timeBest(RUNS, [&]() {
+            palette->clear();
+            for (auto& pixel : pixels) {
+                checksum += palette->add(pixel);
+            }
+            });
+        float hitRate = palette->getCacheHitRate();
+
+        // Same lookups against the already filled palette, without the cache.
+        double lookupTime = timeBest(RUNS, [&]() {
+            for (auto& pixel : pixels) {
+                checksum += palette->indexOf(pixel);
+            }
+            });
+
+        printf("%-8s %6d colors, add: %8.2f Mpx/s (%5.1f%% cache hits), indexOf: %8.2f Mpx/s [%lld]\n",
+            name, palette->count,
+            FRAME_SIZE / addTime * 1e-6, hitRate * 100.0f,
+            FRAME_SIZE / lookupTime * 1e-6, (long long)checksum);
+    }
+}
+
+int main() {
+    runCase("runs", makeRuns);
+    runCase("noise", makeNoise);
+    runCase("unique", makeUnique);
+    return 0;
+}
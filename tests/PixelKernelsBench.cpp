@@ -0,0 +1,71 @@
+#include <PixelKernels.h>
+#include <TestUtils.h>
+#include <random>
+#include <vector>
+using namespace Projections;
+using namespace JCore;
+using Tests::timeBest;
+
+// Times the index kernels against the plain loops they replace, on frame sized buffers.
+namespace {
+    constexpr size_t FRAME_SIZE = 512 * 512;
+    constexpr int32_t RUNS = 7;
+
+    void report(const char* name, double scalarTime, double simdTime, bool match) {
+        printf("%-12s scalar: %8.2f Mpx/s, SIMD: %8.2f Mpx/s%s\n", name,
+            FRAME_SIZE / scalarTime * 1e-6, FRAME_SIZE / simdTime * 1e-6,
+            match ? "" : " (MISMATCH)");
+    }
+}
+
+int main() {
+    std::mt19937 rng(0xB3);
+    std::vector<uint16_t> wide(FRAME_SIZE), wideOut(FRAME_SIZE);
+    std::vector<uint8_t> narrow(FRAME_SIZE), narrowOut(FRAME_SIZE);
+    for (size_t i = 0; i < FRAME_SIZE; i++) {
+        wide[i] = uint16_t(1000 + rng() % 256);
+        narrow[i] = uint8_t(rng());
+    }
+
+    {
+        uint16_t lo = 0, hi = 0, simdLo = 0, simdHi = 0;
+        double scalarTime = timeBest(RUNS, [&]() {
+            lo = wide[0], hi = wide[0];
+            for (auto value : wide) {
+                lo = value < lo ? value : lo;
+                hi = value > hi ? value : hi;
+            }
+            });
+        double simdTime = timeBest(RUNS, [&]() {
+            Kernels::rangeUI16(wide.data(), wide.size(), simdLo, simdHi);
+            });
+        report("rangeUI16", scalarTime, simdTime, lo == simdLo && hi == simdHi);
+    }
+
+    {
+        double scalarTime = timeBest(RUNS, [&]() {
+            for (size_t i = 0; i < FRAME_SIZE; i++) {
+                narrowOut[i] = uint8_t(wide[i] - 1000);
+            }
+            });
+        std::vector<uint8_t> expected = narrowOut;
+        double simdTime = timeBest(RUNS, [&]() {
+            Kernels::narrowUI16(wide.data(), narrowOut.data(), FRAME_SIZE, 1000);
+            });
+        report("narrowUI16", scalarTime, simdTime, expected == narrowOut);
+    }
+
+    {
+        double scalarTime = timeBest(RUNS, [&]() {
+            for (size_t i = 0; i < FRAME_SIZE; i++) {
+                wideOut[i] = narrow[i];
+            }
+            });
+        std::vector<uint16_t> expected = wideOut;
+        double simdTime = timeBest(RUNS, [&]() {
+            Kernels::widenUI8(narrow.data(), wideOut.data(), FRAME_SIZE);
+            });
+        report("widenUI8", scalarTime, simdTime, expected == wideOut);
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <PixelKernels.h>
+#include <TestUtils.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+using namespace Projections;
+using namespace JCore;
+
+// Checks the SIMD index and premultiply kernels against plain loops. Every length from zero
+// up to a few full steps is run at every start offset within a vector, so the scalar tails
+// and unaligned loads are covered along with the vector loops.
+namespace {
+    constexpr size_t MAX_COUNT = 80;
+    constexpr size_t MAX_OFFSET = 16;
+
+    void checkRange(std::mt19937& rng) {
+        std::vector<uint16_t> src(MAX_COUNT + MAX_OFFSET);
+        for (size_t count = 1; count <= MAX_COUNT; count++) {
+            for (size_t offset = 0; offset < MAX_OFFSET; offset++) {
+                for (auto& value : src) {
+                    value = uint16_t(rng());
+                }
+
+                // Put the extremes in the tail now and then, past the last full vector.
+                if (count > 8 && (rng() & 0x1)) {
+                    src[offset + count - 1] = (rng() & 0x1) ? 0 : 0xFFFF;
+                }
+
+                uint16_t lowest = 0, highest = 0;
+                Kernels::rangeUI16(src.data() + offset, count, lowest, highest);
+
+                uint16_t lo = src[offset], hi = src[offset];
+                for (size_t i = 0; i < count; i++) {
+                    lo = std::min(lo, src[offset + i]);
+                    hi = std::max(hi, src[offset + i]);
+                }
+                PROJ_CHECK(lowest == lo && highest == hi);
+            }
+        }
+    }
+
+    void checkNarrow(std::mt19937& rng) {
+        std::vector<uint16_t> src(MAX_COUNT + MAX_OFFSET);
+        std::vector<uint8_t> dst(MAX_COUNT + MAX_OFFSET + 1);
+        for (size_t count = 0; count <= MAX_COUNT; count++) {
+            for (size_t offset = 0; offset < MAX_OFFSET; offset++) {
+                uint16_t base = uint16_t(rng() % (65536 - 256));
+                for (auto& value : src) {
+                    value = uint16_t(base + rng() % 256);
+                }
+
+                std::fill(dst.begin(), dst.end(), uint8_t(0xCD));
+                Kernels::narrowUI16(src.data() + offset, dst.data() + offset, count, base);
+
+                bool valid = dst[offset + count] == 0xCD;
+                for (size_t i = 0; i < offset; i++) {
+                    valid &= dst[i] == 0xCD;
+                }
+                for (size_t i = 0; i < count; i++) {
+                    valid &= dst[offset + i] == uint8_t(src[offset + i] - base);
+                }
+                PROJ_CHECK(valid);
+            }
+        }
+    }
+
+    void checkWiden(std::mt19937& rng) {
+        std::vector<uint8_t> src(MAX_COUNT + MAX_OFFSET);
+        std::vector<uint16_t> dst(MAX_COUNT + MAX_OFFSET + 1);
+        for (size_t count = 0; count <= MAX_COUNT; count++) {
+            for (size_t offset = 0; offset < MAX_OFFSET; offset++) {
+                for (auto& value : src) {
+                    value = uint8_t(rng());
+                }
+
+                std::fill(dst.begin(), dst.end(), uint16_t(0xCDCD));
+                Kernels::widenUI8(src.data() + offset, dst.data() + offset, count);
+
+                bool valid = dst[offset + count] == 0xCDCD;
+                for (size_t i = 0; i < offset; i++) {
+                    valid &= dst[i] == 0xCDCD;
+                }
+                for (size_t i = 0; i < count; i++) {
+                    valid &= dst[offset + i] == src[offset + i];
+                }
+                PROJ_CHECK(valid);
+            }
+        }
+    }
+
+    // mulDiv255 has to be 'a * b / 255' rounded to nearest for every pair of bytes.
+    void checkMulDiv255() {
+        bool valid = true;
+        for (uint32_t a = 0; a < 256; a++) {
+            for (uint32_t b = 0; b < 256; b++) {
+                valid &= Kernels::mulDiv255(a, b) == (a * b * 2 + 255) / 510;
+            }
+        }
+        PROJ_CHECK(valid);
+    }
+
+    void checkPremultiply(std::mt19937& rng) {
+        std::vector<Color32> colors(MAX_COUNT);
+        for (size_t count = 0; count <= MAX_COUNT; count++) {
+            for (auto& color : colors) {
+                color = Color32(uint8_t(rng()), uint8_t(rng()), uint8_t(rng()), uint8_t(rng()));
+            }
+
+            std::vector<Color32> expected = colors;
+            for (size_t i = 0; i < count; i++) {
+                auto& c = expected[i];
+                c.r = Kernels::mulDiv255(c.r, c.a);
+                c.g = Kernels::mulDiv255(c.g, c.a);
+                c.b = Kernels::mulDiv255(c.b, c.a);
+            }
+
+            Kernels::premultiplyRGBA32(colors.data(), count);
+            PROJ_CHECK(memcmp(colors.data(), expected.data(), colors.size() * sizeof(Color32)) == 0);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(0x5EED);
+    checkRange(rng);
+    checkNarrow(rng);
+    checkWiden(rng);
+    checkMulDiv255();
+    checkPremultiply(rng);
+    return Tests::finish("PixelKernelsTest");
+}
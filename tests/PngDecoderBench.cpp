@@ -0,0 +1,163 @@
+#include <MappedImage.h>
+#include <PngDecoder.h>
+#include <PngWriter.h>
+#include <TestUtils.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <J-Core/IO/Image.h>
+using namespace Projections;
+using namespace Projections::Tests;
+using namespace JCore;
+namespace fs = std::filesystem;
+
+// Decode throughput of the built-in PNG decoder against J-Core's Png::decode, the path it replaces.
+// Both read the same files, a frame sized image in every deflate mode with flat shaded content that
+// compresses well and noisy content that mostly doesn't. Pass a directory to also run every PNG
+// under it, eg. the frames of a real projection.
+namespace {
+    constexpr uint32_t WIDTH = 1024;
+    constexpr uint32_t HEIGHT = 1024;
+    constexpr int32_t RUNS = 5;
+    constexpr int32_t CORPUS_RUNS = 3;
+
+    struct Timing {
+        double builtIn{};
+        double jCore{};
+        size_t pixels{};
+        size_t bytes{};
+        size_t files{};
+        size_t skipped{};
+        size_t mismatched{};
+
+        void print(const char* name) const {
+            printf("%-16s %6zu files, %10zu bytes, built-in: %8.2f Mpx/s, J-Core: %8.2f Mpx/s (%.2fx)",
+                name, files, bytes,
+                pixels / builtIn * 1e-6, pixels / jCore * 1e-6, jCore / builtIn);
+            if (skipped > 0) { printf(", %zu unsupported", skipped); }
+            if (mismatched > 0) { printf(", %zu MISMATCHED", mismatched); }
+            printf("\n");
+        }
+    };
+
+    bool isSameImage(const ImageData& lhs, const ImageData& rhs) {
+        return lhs.width == rhs.width && lhs.height == rhs.height && lhs.format == rhs.format &&
+            memcmp(lhs.data, rhs.data, lhs.getSize()) == 0;
+    }
+
+    // Times both decoders on one file. Files the built-in decoder doesn't handle count as skipped,
+    // J-Core keeps decoding those in the tool so there's nothing to compare.
+    void timeFile(const std::string& path, int32_t runs, Timing& timing) {
+        ImageData builtIn{}, reference{};
+        bool valid = true;
+        double builtInTime = timeBest(runs, [&]() {
+            valid &= decodeMapped(path, FMT_PNG, builtIn);
+            });
+        if (!valid) {
+            timing.skipped++;
+            builtIn.clear(true);
+            return;
+        }
+
+        double jCoreTime = timeBest(runs, [&]() {
+            valid &= Png::decode(path.c_str(), reference);
+            });
+
+        // J-Core may keep RGB sources as RGB24, only same format results can be compared.
+        if (!valid || (reference.format == builtIn.format && !isSameImage(builtIn, reference))) {
+            timing.mismatched++;
+        }
+
+        std::error_code err{};
+        timing.builtIn += builtInTime;
+        timing.jCore += jCoreTime;
+        timing.pixels += size_t(builtIn.width) * builtIn.height;
+        timing.bytes += size_t(fs::file_size(path, err));
+        timing.files++;
+
+        builtIn.clear(true);
+        reference.clear(true);
+    }
+
+    bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+        return bool(file);
+    }
+
+    void makeFlat(std::vector<uint8_t>& pixels, std::mt19937& rng) {
+        uint32_t colors[16]{};
+        for (auto& color : colors) {
+            color = rng() | 0xFF000000U;
+        }
+
+        for (size_t i = 0; i < pixels.size();) {
+            size_t len = 4 * (1 + rng() % 48);
+            uint32_t color = colors[rng() % 16];
+            for (; len > 0 && i < pixels.size(); len--, i++) {
+                pixels[i] = uint8_t(color >> ((i & 0x3) * 8));
+            }
+        }
+    }
+
+    void makeNoise(std::vector<uint8_t>& pixels, std::mt19937& rng) {
+        for (auto& value : pixels) {
+            value = uint8_t(rng());
+        }
+    }
+
+    void runCase(const char* name, void(*generate)(std::vector<uint8_t>&, std::mt19937&), const std::string& root) {
+        std::mt19937 rng(0xB4);
+        std::vector<uint8_t> pixels(size_t(WIDTH) * HEIGHT * 4);
+        generate(pixels, rng);
+
+        const char* modeNames[] = { "stored", "fixed", "dynamic" };
+        std::string path = (fs::path(root) / "PngDecoderBench.png").string();
+        for (DeflateMode mode : { DEFLATE_Stored, DEFLATE_Fixed, DEFLATE_Dynamic }) {
+            if (!writeFile(path, encodePng(pixels.data(), WIDTH, HEIGHT, true, mode))) {
+                printf("Failed to write '%s'\n", path.c_str());
+                return;
+            }
+
+            Timing timing{};
+            timeFile(path, RUNS, timing);
+
+            char label[32]{};
+            snprintf(label, sizeof(label), "%s %s", name, modeNames[mode]);
+            timing.print(label);
+        }
+
+        std::error_code err{};
+        fs::remove(path, err);
+    }
+
+    void runCorpus(const std::string& dir) {
+        Timing timing{};
+        std::error_code err{};
+        for (fs::recursive_directory_iterator it(dir, err), end; !err && it != end; it.increment(err)) {
+            if (!it->is_regular_file(err) || getImageFormat(it->path().string()) != FMT_PNG) { continue; }
+            timeFile(it->path().string(), CORPUS_RUNS, timing);
+        }
+
+        if (timing.files < 1) {
+            printf("No decodable PNGs under '%s'\n", dir.c_str());
+            return;
+        }
+        timing.print("corpus");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::error_code err{};
+    std::string root = fs::temp_directory_path(err).string();
+
+    runCase("flat", makeFlat, root);
+    runCase("noise", makeNoise, root);
+    if (argc > 1) {
+        runCorpus(argv[1]);
+    }
+    return 0;
+}
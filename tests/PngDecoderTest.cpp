@@ -0,0 +1,269 @@
+#include <PngDecoder.h>
+#include <PngWriter.h>
+#include <TestUtils.h>
+#include <random>
+#include <vector>
+using namespace Projections;
+using namespace Projections::Tests;
+using namespace JCore;
+
+// Round trips through the built-in PNG decoder, then feeds it truncated streams,
+// malformed Huffman tables and randomly corrupted files. Anything malformed has to
+// be rejected, and nothing may read or write out of bounds while doing so.
+namespace {
+    struct Source {
+        uint32_t width{};
+        uint32_t height{};
+        bool hasAlpha{};
+        std::vector<uint8_t> pixels{};
+    };
+
+    // Runs of a few colors with some noise, so every deflate mode finds matches at all distances.
+    Source makeSource(uint32_t width, uint32_t height, bool hasAlpha, std::mt19937& rng) {
+        Source src{ width, height, hasAlpha };
+        size_t bpp = hasAlpha ? 4 : 3;
+        src.pixels.resize(size_t(width) * height * bpp);
+
+        uint8_t colors[4][4]{};
+        for (auto& color : colors) {
+            for (auto& value : color) {
+                value = uint8_t(rng());
+            }
+        }
+
+        for (size_t i = 0; i < size_t(width) * height; i++) {
+            const uint8_t* color = colors[(i / 7) % 4];
+            bool isNoise = rng() % 5 == 0;
+            for (size_t c = 0; c < bpp; c++) {
+                src.pixels[i * bpp + c] = isNoise ? uint8_t(rng()) : color[c];
+            }
+        }
+        return src;
+    }
+
+    bool matches(const Source& src, const ImageData& img) {
+        if (img.width != int32_t(src.width) || img.height != int32_t(src.height) || img.format != TextureFormat::RGBA32) { return false; }
+
+        size_t bpp = src.hasAlpha ? 4 : 3;
+        for (size_t i = 0; i < size_t(src.width) * src.height; i++) {
+            const uint8_t* px = img.data + i * 4;
+            const uint8_t* ref = src.pixels.data() + i * bpp;
+            if (px[0] != ref[0] || px[1] != ref[1] || px[2] != ref[2] || px[3] != (src.hasAlpha ? ref[3] : 0xFF)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool decode(const std::vector<uint8_t>& png, ImageData& img) {
+        return PngDecoder::decode(png.data(), png.size(), img);
+    }
+
+    void checkRoundTrips(std::mt19937& rng, ImageData& img) {
+        const uint32_t sizes[][2] = { { 1, 1 }, { 3, 2 }, { 17, 5 }, { 64, 33 }, { 257, 3 } };
+        const DeflateMode modes[] = { DEFLATE_Stored, DEFLATE_Fixed, DEFLATE_Dynamic };
+
+        for (auto& size : sizes) {
+            for (bool hasAlpha : { false, true }) {
+                Source src = makeSource(size[0], size[1], hasAlpha, rng);
+                for (DeflateMode mode : modes) {
+                    for (size_t idatCount : { size_t(1), size_t(3) }) {
+                        PROJ_CHECK(decode(encodePng(src.pixels.data(), src.width, src.height, hasAlpha, mode, idatCount), img) && matches(src, img));
+                    }
+                }
+            }
+        }
+
+        // Stored streams over 64 KB take several blocks.
+        Source large = makeSource(160, 120, true, rng);
+        PROJ_CHECK(decode(encodePng(large.pixels.data(), large.width, large.height, true, DEFLATE_Stored), img) && matches(large, img));
+    }
+
+    // The file cut short anywhere, and the zlib stream cut short inside a well formed file.
+    void checkTruncated(std::mt19937& rng, ImageData& img) {
+        Source src = makeSource(23, 9, true, rng);
+        std::vector<uint8_t> raw = filterRows(src.pixels.data(), src.width, src.height, 4);
+
+        for (DeflateMode mode : { DEFLATE_Stored, DEFLATE_Fixed, DEFLATE_Dynamic }) {
+            std::vector<uint8_t> png = encodePng(src.pixels.data(), src.width, src.height, true, mode);
+            for (size_t len = 0; len < png.size(); len++) {
+                std::vector<uint8_t> cut(png.begin(), png.begin() + len);
+                PROJ_CHECK(!decode(cut, img));
+            }
+
+            BitWriter writer{};
+            writeDeflate(writer, raw.data(), raw.size(), mode, 4, raw.size() / src.height);
+            std::vector<uint8_t> zlib = wrapZlib(writer.data, raw.data(), raw.size());
+
+            // The Adler-32 trailer isn't needed to decode, everything before it is.
+            for (size_t len = 0; len + 4 < zlib.size(); len++) {
+                std::vector<uint8_t> cut(zlib.begin(), zlib.begin() + len);
+                PROJ_CHECK(!decode(wrapPng(cut, src.width, src.height, true), img));
+            }
+        }
+    }
+
+    std::vector<uint8_t> makeDynamic(uint32_t hlit, uint32_t hdist, uint32_t hclen, const uint8_t* codeLengths,
+        const std::vector<LengthSymbol>& symbols, const std::vector<uint32_t>& data = {}, const HuffmanTable* lit = nullptr) {
+        BitWriter writer{};
+        writeDynamicHeader(writer, true, hlit, hdist, hclen, codeLengths, symbols);
+        if (lit) {
+            for (uint32_t sym : data) {
+                lit->write(writer, sym);
+            }
+        }
+        writer.align();
+
+        std::vector<uint8_t> zlib{ 0x78, 0x01 };
+        zlib.insert(zlib.end(), writer.data.begin(), writer.data.end());
+        zlib.insert(zlib.end(), 4, 0);
+        return wrapPng(zlib, 1, 1, true);
+    }
+
+    void checkBadTables(ImageData& img) {
+        uint8_t codeLengths[19];
+        getDynamicCodeLengths(codeLengths);
+
+        HuffmanTable lit = getDynamicLiterals();
+        HuffmanTable dist = getDynamicDistances();
+        std::vector<uint8_t> lengths = lit.lengths;
+        lengths.insert(lengths.end(), dist.lengths.begin(), dist.lengths.end());
+
+        // One filter byte and an RGBA pixel, the well formed table has to decode.
+        std::vector<uint32_t> pixel = { 0, 1, 2, 3, 4, 256 };
+        PROJ_CHECK(decode(makeDynamic(286, 30, 12, codeLengths, encodeLengths(lengths), pixel, &lit), img));
+
+        // Oversubscribed code length code.
+        uint8_t oversubscribed[19];
+        memset(oversubscribed, 1, sizeof(oversubscribed));
+        PROJ_CHECK(!decode(makeDynamic(286, 30, 19, oversubscribed, {}), img));
+
+        // Oversubscribed literal/length code, 316 codes of 8 bits don't fit.
+        std::vector<uint8_t> tooMany(lengths.size(), 8);
+        PROJ_CHECK(!decode(makeDynamic(286, 30, 12, codeLengths, encodeLengths(tooMany), pixel, &lit), img));
+
+        // No end of block code.
+        std::vector<uint8_t> noEnd = lengths;
+        noEnd[256] = 0;
+        uint8_t withZero[19];
+        memcpy(withZero, codeLengths, sizeof(withZero));
+        withZero[0] = 4;
+        withZero[4] = 4;
+        PROJ_CHECK(!decode(makeDynamic(286, 30, 12, withZero, encodeLengths(noEnd)), img));
+
+        // Repeat of the previous length with nothing before it.
+        PROJ_CHECK(!decode(makeDynamic(286, 30, 12, codeLengths, { { 16, 0 } }), img));
+
+        // Repeat running past the end of the tables.
+        std::vector<LengthSymbol> overrun = encodeLengths(lengths);
+        overrun.pop_back();
+        overrun.push_back({ 16, 3 });
+        PROJ_CHECK(!decode(makeDynamic(286, 30, 12, codeLengths, overrun), img));
+
+        // Incomplete literal code whose data then uses a missing code. Only the end of block
+        // and three literals get codes, the all ones code is unassigned.
+        std::vector<uint8_t> sparse(286 + 30, 0);
+        sparse[0] = 2;
+        sparse[1] = 2;
+        sparse[2] = 3;
+        sparse[256] = 2;
+        sparse[286] = 1;
+        {
+            uint8_t sparseLengths[19]{ 2, 2, 2, 2 };
+            std::vector<LengthSymbol> symbols{};
+            for (uint8_t len : sparse) {
+                symbols.push_back({ len, 0 });
+            }
+
+            BitWriter writer{};
+            writeDynamicHeader(writer, true, 286, 30, 19, sparseLengths, symbols);
+            HuffmanTable sparseLit(std::vector<uint8_t>(sparse.begin(), sparse.begin() + 286));
+            sparseLit.write(writer, 0);
+            writer.putCode(0x7, 3);
+            writer.put(0, 16);
+            writer.align();
+
+            std::vector<uint8_t> zlib{ 0x78, 0x01 };
+            zlib.insert(zlib.end(), writer.data.begin(), writer.data.end());
+            PROJ_CHECK(!decode(wrapPng(zlib, 1, 1, true), img));
+        }
+
+        // Distance reaching back before the start of the output.
+        {
+            BitWriter writer{};
+            writer.put(1, 1);
+            writer.put(1, 2);
+            HuffmanTable fixedLit = getFixedLiterals();
+            fixedLit.write(writer, 0);
+            fixedLit.write(writer, 257);
+            getFixedDistances().write(writer, 3);
+            fixedLit.write(writer, 256);
+            writer.align();
+
+            std::vector<uint8_t> zlib{ 0x78, 0x01 };
+            zlib.insert(zlib.end(), writer.data.begin(), writer.data.end());
+            PROJ_CHECK(!decode(wrapPng(zlib, 1, 1, true), img));
+        }
+
+        // Fixed code distance symbols 30 and 31 don't exist.
+        {
+            BitWriter writer{};
+            writer.put(1, 1);
+            writer.put(1, 2);
+            HuffmanTable fixedLit = getFixedLiterals();
+            fixedLit.write(writer, 0);
+            fixedLit.write(writer, 257);
+            writer.putCode(30, 5);
+            fixedLit.write(writer, 256);
+            writer.align();
+
+            std::vector<uint8_t> zlib{ 0x78, 0x01 };
+            zlib.insert(zlib.end(), writer.data.begin(), writer.data.end());
+            PROJ_CHECK(!decode(wrapPng(zlib, 1, 1, true), img));
+        }
+
+        // Reserved block type and a stored block whose length check doesn't match.
+        {
+            std::vector<uint8_t> reserved{ 0x78, 0x01, 0x07, 0, 0, 0, 0 };
+            PROJ_CHECK(!decode(wrapPng(reserved, 1, 1, true), img));
+
+            std::vector<uint8_t> stored{ 0x78, 0x01, 0x01, 5, 0, 0xFA, 0xFE, 0, 1, 2, 3, 4 };
+            PROJ_CHECK(!decode(wrapPng(stored, 1, 1, true), img));
+        }
+    }
+
+    // Random byte corruption of valid files. Most of them get rejected, the ones that don't
+    // still have to come out with the size their header claims.
+    void checkCorrupted(std::mt19937& rng, ImageData& img) {
+        static constexpr int32_t ITERATIONS = 3000;
+
+        Source src = makeSource(31, 17, true, rng);
+        for (DeflateMode mode : { DEFLATE_Stored, DEFLATE_Fixed, DEFLATE_Dynamic }) {
+            std::vector<uint8_t> png = encodePng(src.pixels.data(), src.width, src.height, true, mode);
+            for (int32_t i = 0; i < ITERATIONS; i++) {
+                std::vector<uint8_t> bad = png;
+                size_t flips = 1 + rng() % 4;
+                for (size_t j = 0; j < flips; j++) {
+                    bad[8 + rng() % (bad.size() - 8)] ^= uint8_t(1 + rng() % 255);
+                }
+
+                if (decode(bad, img)) {
+                    uint32_t width = (uint32_t(bad[16]) << 24) | (uint32_t(bad[17]) << 16) | (uint32_t(bad[18]) << 8) | bad[19];
+                    uint32_t height = (uint32_t(bad[20]) << 24) | (uint32_t(bad[21]) << 16) | (uint32_t(bad[22]) << 8) | bad[23];
+                    PROJ_CHECK(img.width == int32_t(width) && img.height == int32_t(height));
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(0xF022);
+    ImageData img{};
+    checkRoundTrips(rng, img);
+    checkTruncated(rng, img);
+    checkBadTables(img);
+    checkCorrupted(rng, img);
+    img.clear(true);
+    return Tests::finish("PngDecoderTest");
+}
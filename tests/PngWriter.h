@@ -0,0 +1,386 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Minimal PNG writer for the PNG decoder tests and benchmark. Streams can be stored,
+// fixed Huffman or dynamic Huffman coded, and the dynamic block writer takes arbitrary
+// code length tables so malformed streams can be built on purpose.
+namespace Projections::Tests {
+    enum DeflateMode : uint8_t {
+        DEFLATE_Stored,
+        DEFLATE_Fixed,
+        DEFLATE_Dynamic,
+    };
+
+    // LSB first bit writer, Huffman codes are written most significant bit first as deflate wants.
+    struct BitWriter {
+        std::vector<uint8_t> data{};
+        uint64_t bits{};
+        uint32_t count{};
+
+        void put(uint32_t value, uint32_t n) {
+            bits |= uint64_t(value & ((uint64_t(1) << n) - 1)) << count;
+            count += n;
+            while (count >= 8) {
+                data.push_back(uint8_t(bits));
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+
+        void putCode(uint32_t code, uint32_t n) {
+            uint32_t reversed = 0;
+            for (uint32_t i = 0; i < n; i++) {
+                reversed |= ((code >> i) & 0x1) << (n - 1 - i);
+            }
+            put(reversed, n);
+        }
+
+        void align() {
+            if (count > 0) {
+                put(0, 8 - count);
+            }
+        }
+    };
+
+    // Canonical codes for a table of code lengths, as deflate assigns them.
+    inline std::vector<uint32_t> makeCodes(const uint8_t* lengths, size_t count) {
+        uint32_t sizes[16]{ 0 };
+        for (size_t i = 0; i < count; i++) {
+            sizes[lengths[i]]++;
+        }
+        sizes[0] = 0;
+
+        uint32_t next[16]{ 0 };
+        uint32_t code = 0;
+        for (uint32_t i = 1; i < 16; i++) {
+            code = (code + sizes[i - 1]) << 1;
+            next[i] = code;
+        }
+
+        std::vector<uint32_t> codes(count, 0);
+        for (size_t i = 0; i < count; i++) {
+            if (lengths[i] > 0) {
+                codes[i] = next[lengths[i]]++;
+            }
+        }
+        return codes;
+    }
+
+    struct HuffmanTable {
+        std::vector<uint8_t> lengths{};
+        std::vector<uint32_t> codes{};
+
+        HuffmanTable() = default;
+        HuffmanTable(std::vector<uint8_t> lens) : lengths(std::move(lens)) {
+            codes = makeCodes(lengths.data(), lengths.size());
+        }
+
+        void write(BitWriter& writer, uint32_t symbol) const {
+            writer.putCode(codes[symbol], lengths[symbol]);
+        }
+    };
+
+    static constexpr uint16_t PNG_LENGTH_BASE[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr uint8_t PNG_LENGTH_EXTRA[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static constexpr uint16_t PNG_DIST_BASE[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static constexpr uint8_t PNG_DIST_EXTRA[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    inline HuffmanTable getFixedLiterals() {
+        std::vector<uint8_t> lengths(288);
+        memset(lengths.data() + 0, 8, 144);
+        memset(lengths.data() + 144, 9, 112);
+        memset(lengths.data() + 256, 7, 24);
+        memset(lengths.data() + 280, 8, 8);
+        return HuffmanTable(lengths);
+    }
+
+    inline HuffmanTable getFixedDistances() {
+        return HuffmanTable(std::vector<uint8_t>(30, 5));
+    }
+
+    // Complete tables over the whole literal/length and distance alphabets, used for dynamic blocks.
+    inline HuffmanTable getDynamicLiterals() {
+        std::vector<uint8_t> lengths(286, 8);
+        for (size_t i = 226; i < lengths.size(); i++) {
+            lengths[i] = 9;
+        }
+        return HuffmanTable(lengths);
+    }
+
+    inline HuffmanTable getDynamicDistances() {
+        std::vector<uint8_t> lengths(30, 5);
+        lengths[0] = 4;
+        lengths[1] = 4;
+        return HuffmanTable(lengths);
+    }
+
+    // Greedy matcher over a few fixed distances, enough to hit every copy path of the decoder.
+    inline void writeSymbols(BitWriter& writer, const uint8_t* data, size_t size, const HuffmanTable& lit, const HuffmanTable& dist, size_t pixelSize, size_t rowSize) {
+        const size_t distances[3] = { rowSize, pixelSize, 1 };
+        for (size_t i = 0; i < size;) {
+            size_t bestLen = 0, bestDist = 0;
+            for (size_t distance : distances) {
+                if (distance < 1 || distance > i || distance > 32768) { continue; }
+
+                size_t len = 0;
+                while (len < 258 && i + len < size && data[i + len] == data[i + len - distance]) {
+                    len++;
+                }
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = distance;
+                }
+            }
+
+            if (bestLen < 3) {
+                lit.write(writer, data[i++]);
+                continue;
+            }
+
+            uint32_t lsym = 28;
+            while (PNG_LENGTH_BASE[lsym] > bestLen) { lsym--; }
+            lit.write(writer, 257 + lsym);
+            writer.put(uint32_t(bestLen - PNG_LENGTH_BASE[lsym]), PNG_LENGTH_EXTRA[lsym]);
+
+            uint32_t dsym = 29;
+            while (PNG_DIST_BASE[dsym] > bestDist) { dsym--; }
+            dist.write(writer, dsym);
+            writer.put(uint32_t(bestDist - PNG_DIST_BASE[dsym]), PNG_DIST_EXTRA[dsym]);
+            i += bestLen;
+        }
+        lit.write(writer, 256);
+    }
+
+    // Code length symbol with its extra bits, 16 to 18 are the repeat codes.
+    struct LengthSymbol {
+        uint8_t symbol{};
+        uint8_t extra{};
+    };
+
+    // Writes a dynamic block header for the given tables as they are, no validation.
+    // 'codeLengths' are the 19 code length code lengths in symbol order, 'hclen' of them are written.
+    inline void writeDynamicHeader(BitWriter& writer, bool isFinal, uint32_t hlit, uint32_t hdist, uint32_t hclen,
+        const uint8_t* codeLengths, const std::vector<LengthSymbol>& symbols) {
+        static constexpr uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        writer.put(isFinal ? 1 : 0, 1);
+        writer.put(2, 2);
+        writer.put(hlit - 257, 5);
+        writer.put(hdist - 1, 5);
+        writer.put(hclen - 4, 4);
+        for (uint32_t i = 0; i < hclen; i++) {
+            writer.put(codeLengths[ORDER[i]], 3);
+        }
+
+        HuffmanTable table(std::vector<uint8_t>(codeLengths, codeLengths + 19));
+        for (auto& sym : symbols) {
+            table.write(writer, sym.symbol);
+            switch (sym.symbol) {
+                case 16: writer.put(sym.extra, 2); break;
+                case 17: writer.put(sym.extra, 3); break;
+                case 18: writer.put(sym.extra, 7); break;
+                default: break;
+            }
+        }
+    }
+
+    // Code length symbols for 'lengths', runs of the previous length use repeat code 16.
+    inline std::vector<LengthSymbol> encodeLengths(const std::vector<uint8_t>& lengths) {
+        std::vector<LengthSymbol> symbols{};
+        for (size_t i = 0; i < lengths.size();) {
+            symbols.push_back({ lengths[i], 0 });
+            size_t run = 1;
+            while (i + run < lengths.size() && lengths[i + run] == lengths[i]) {
+                run++;
+            }
+
+            size_t repeat = run - 1;
+            while (repeat >= 3) {
+                size_t count = repeat > 6 ? 6 : repeat;
+                symbols.push_back({ 16, uint8_t(count - 3) });
+                repeat -= count;
+            }
+            for (; repeat > 0; repeat--) {
+                symbols.push_back({ lengths[i], 0 });
+            }
+            i += run;
+        }
+        return symbols;
+    }
+
+    // Code length code covering what 'getDynamicLiterals' and 'getDynamicDistances' need.
+    inline void getDynamicCodeLengths(uint8_t* codeLengths) {
+        memset(codeLengths, 0, 19);
+        codeLengths[8] = 2;
+        codeLengths[9] = 2;
+        codeLengths[5] = 2;
+        codeLengths[4] = 3;
+        codeLengths[16] = 3;
+    }
+
+    inline void writeDeflate(BitWriter& writer, const uint8_t* data, size_t size, DeflateMode mode, size_t pixelSize, size_t rowSize) {
+        switch (mode) {
+            case DEFLATE_Stored: {
+                size_t pos = 0;
+                do {
+                    size_t len = size - pos > 65535 ? 65535 : size - pos;
+                    writer.put(pos + len >= size ? 1 : 0, 1);
+                    writer.put(0, 2);
+                    writer.align();
+                    writer.put(uint32_t(len), 16);
+                    writer.put(uint32_t(len ^ 0xFFFF), 16);
+                    for (size_t i = 0; i < len; i++) {
+                        writer.put(data[pos + i], 8);
+                    }
+                    pos += len;
+                } while (pos < size);
+                break;
+            }
+            case DEFLATE_Fixed:
+                writer.put(1, 1);
+                writer.put(1, 2);
+                writeSymbols(writer, data, size, getFixedLiterals(), getFixedDistances(), pixelSize, rowSize);
+                break;
+            case DEFLATE_Dynamic: {
+                HuffmanTable lit = getDynamicLiterals();
+                HuffmanTable dist = getDynamicDistances();
+                std::vector<uint8_t> lengths = lit.lengths;
+                lengths.insert(lengths.end(), dist.lengths.begin(), dist.lengths.end());
+
+                uint8_t codeLengths[19];
+                getDynamicCodeLengths(codeLengths);
+                writeDynamicHeader(writer, true, uint32_t(lit.lengths.size()), uint32_t(dist.lengths.size()), 12, codeLengths, encodeLengths(lengths));
+                writeSymbols(writer, data, size, lit, dist, pixelSize, rowSize);
+                break;
+            }
+        }
+        writer.align();
+    }
+
+    inline uint32_t adler32(const uint8_t* data, size_t size) {
+        uint32_t a = 1, b = 0;
+        for (size_t i = 0; i < size; i++) {
+            a = (a + data[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    // zlib wrapper around a raw deflate stream, 'deflate' is the stream without the header.
+    inline std::vector<uint8_t> wrapZlib(const std::vector<uint8_t>& deflate, const uint8_t* data, size_t size) {
+        std::vector<uint8_t> out{ 0x78, 0x01 };
+        out.insert(out.end(), deflate.begin(), deflate.end());
+        uint32_t adler = adler32(data, size);
+        for (int32_t i = 3; i >= 0; i--) {
+            out.push_back(uint8_t(adler >> (i * 8)));
+        }
+        return out;
+    }
+
+    inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc ^= data[i];
+            for (int32_t j = 0; j < 8; j++) {
+                crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 0x1)));
+            }
+        }
+        return ~crc;
+    }
+
+    inline void writeBE32(std::vector<uint8_t>& out, uint32_t value) {
+        for (int32_t i = 3; i >= 0; i--) {
+            out.push_back(uint8_t(value >> (i * 8)));
+        }
+    }
+
+    inline void writeChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+        writeBE32(out, uint32_t(size));
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data, data + size);
+        writeBE32(out, crc32(out.data() + start, out.size() - start));
+    }
+
+    // Filters every row with filter 'y % 5', so all five filters are used.
+    inline std::vector<uint8_t> filterRows(const uint8_t* pixels, uint32_t width, uint32_t height, size_t bpp) {
+        size_t rowBytes = size_t(width) * bpp;
+        std::vector<uint8_t> raw{};
+        raw.reserve((rowBytes + 1) * height);
+
+        std::vector<uint8_t> zero(rowBytes, 0);
+        for (uint32_t y = 0; y < height; y++) {
+            const uint8_t* row = pixels + y * rowBytes;
+            const uint8_t* prev = y > 0 ? row - rowBytes : zero.data();
+            uint8_t filter = uint8_t(y % 5);
+            raw.push_back(filter);
+
+            for (size_t x = 0; x < rowBytes; x++) {
+                int32_t a = x >= bpp ? row[x - bpp] : 0;
+                int32_t b = prev[x];
+                int32_t c = x >= bpp ? prev[x - bpp] : 0;
+
+                int32_t pred = 0;
+                switch (filter) {
+                    case 1: pred = a; break;
+                    case 2: pred = b; break;
+                    case 3: pred = (a + b) >> 1; break;
+                    case 4: {
+                        int32_t p = a + b - c;
+                        int32_t pa = p > a ? p - a : a - p;
+                        int32_t pb = p > b ? p - b : b - p;
+                        int32_t pc = p > c ? p - c : c - p;
+                        pred = pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+                        break;
+                    }
+                }
+                raw.push_back(uint8_t(row[x] - pred));
+            }
+        }
+        return raw;
+    }
+
+    // Wraps a zlib stream into a PNG, split over 'idatCount' IDAT chunks.
+    inline std::vector<uint8_t> wrapPng(const std::vector<uint8_t>& zlib, uint32_t width, uint32_t height, bool hasAlpha, size_t idatCount = 1) {
+        static constexpr uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        std::vector<uint8_t> out(SIGNATURE, SIGNATURE + 8);
+
+        std::vector<uint8_t> ihdr{};
+        writeBE32(ihdr, width);
+        writeBE32(ihdr, height);
+        ihdr.push_back(8);
+        ihdr.push_back(hasAlpha ? 6 : 2);
+        ihdr.push_back(0);
+        ihdr.push_back(0);
+        ihdr.push_back(0);
+        writeChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+        size_t step = (zlib.size() + idatCount - 1) / idatCount;
+        for (size_t pos = 0; pos < zlib.size(); pos += step) {
+            size_t len = zlib.size() - pos < step ? zlib.size() - pos : step;
+            writeChunk(out, "IDAT", zlib.data() + pos, len);
+        }
+        writeChunk(out, "IEND", nullptr, 0);
+        return out;
+    }
+
+    // 'pixels' are tightly packed RGB or RGBA rows.
+    inline std::vector<uint8_t> encodePng(const uint8_t* pixels, uint32_t width, uint32_t height, bool hasAlpha, DeflateMode mode, size_t idatCount = 1) {
+        size_t bpp = hasAlpha ? 4 : 3;
+        std::vector<uint8_t> raw = filterRows(pixels, width, height, bpp);
+
+        BitWriter writer{};
+        writeDeflate(writer, raw.data(), raw.size(), mode, bpp, size_t(width) * bpp + 1);
+        return wrapPng(wrapZlib(writer.data, raw.data(), raw.size()), width, height, hasAlpha, idatCount);
+    }
+}
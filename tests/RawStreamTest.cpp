@@ -0,0 +1,100 @@
+#include <RawStream.h>
+#include <TestUtils.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+using namespace Projections;
+using namespace JCore;
+namespace fs = std::filesystem;
+
+// Opens synthetic raw RGBA32 files and checks how many frames are taken out of them,
+// including files that end in a partial frame and 'frameCount' limits over and under
+// what the file holds. Frame contents are checked against what was written.
+namespace {
+    constexpr int32_t WIDTH = 5;
+    constexpr int32_t HEIGHT = 3;
+    constexpr size_t FRAME_BYTES = size_t(WIDTH) * HEIGHT * 4;
+
+    uint8_t getByte(size_t frame, size_t i) {
+        return uint8_t(frame * 31 + i * 7 + 1);
+    }
+
+    // Writes 'frames' whole frames followed by 'extra' bytes of a partial one.
+    bool writeRaw(const std::string& path, size_t frames, size_t extra) {
+        std::vector<uint8_t> data(frames * FRAME_BYTES + extra);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = getByte(i / FRAME_BYTES, i % FRAME_BYTES);
+        }
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) { return false; }
+        bool written = data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size();
+        fclose(file);
+        return written;
+    }
+
+    bool isFrame(const ImageData& img, size_t frame) {
+        if (img.width != WIDTH || img.height != HEIGHT || img.format != TextureFormat::RGBA32) { return false; }
+        for (size_t i = 0; i < FRAME_BYTES; i++) {
+            if (img.data[i] != getByte(frame, i)) { return false; }
+        }
+        return true;
+    }
+
+    // Opens 'frames' whole frames plus 'extra' bytes with a 'maxFrames' limit and checks the frame count.
+    void checkOpen(const std::string& root, size_t frames, size_t extra, size_t maxFrames, size_t expected, ImageData& img) {
+        const std::string name = "RawStreamTest.raw";
+        PROJ_CHECK(writeRaw((fs::path(root) / name).string(), frames, extra));
+
+        StreamSource source(name, WIDTH, HEIGHT);
+        bool opened = source.open(root, maxFrames);
+        PROJ_CHECK(opened == (expected > 0));
+        PROJ_CHECK(source.getFrameCount() == expected);
+
+        for (size_t i = 0; i < expected; i++) {
+            PROJ_CHECK(source.readFrame(i, img) && isFrame(img, i));
+        }
+        PROJ_CHECK(!source.readFrame(expected, img));
+
+        // Reopening has to give the same frames, prepare runs again on every reload.
+        PROJ_CHECK(source.open(root, maxFrames) == opened && source.getFrameCount() == expected);
+        source.close();
+    }
+}
+
+int main() {
+    std::error_code err{};
+    std::string root = fs::temp_directory_path(err).string();
+    PROJ_CHECK(!err);
+
+    ImageData img{};
+
+    // Whole frames only.
+    checkOpen(root, 4, 0, 0, 4, img);
+    checkOpen(root, 1, 0, 0, 1, img);
+
+    // A partial trailing frame is dropped, alone it leaves nothing to read.
+    checkOpen(root, 4, 1, 0, 4, img);
+    checkOpen(root, 4, FRAME_BYTES - 1, 0, 4, img);
+    checkOpen(root, 0, FRAME_BYTES - 1, 0, 0, img);
+    checkOpen(root, 0, 0, 0, 0, img);
+
+    // 'frameCount' clamps to what's there either way.
+    checkOpen(root, 4, 0, 2, 2, img);
+    checkOpen(root, 4, 0, 4, 4, img);
+    checkOpen(root, 4, 0, 9, 4, img);
+    checkOpen(root, 4, 7, 4, 4, img);
+    checkOpen(root, 4, 7, 5, 4, img);
+
+    // No frame size, nothing can be read.
+    {
+        StreamSource source("RawStreamTest.raw", 0, HEIGHT);
+        PROJ_CHECK(!source.open(root, 0) && source.getFrameCount() == 0);
+    }
+
+    fs::remove(fs::path(root) / "RawStreamTest.raw", err);
+    img.clear(true);
+    return Tests::finish("RawStreamTest");
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace Projections::Tests {
+    inline int32_t& getFailures() {
+        static int32_t failures = 0;
+        return failures;
+    }
+
+    // Runs 'func' 'runs' times and returns the fastest run in seconds.
+    template<typename Func>
+    inline double timeBest(int32_t runs, Func func) {
+        double best = 0;
+        for (int32_t i = 0; i < runs; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            best = i == 0 || time < best ? time : best;
+        }
+        return best;
+    }
+
+    inline int32_t finish(const char* name) {
+        int32_t failures = getFailures();
+        if (failures > 0) {
+            printf("%s: %d check(s) failed\n", name, failures);
+        }
+        else {
+            printf("%s: all checks passed\n", name);
+        }
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#define PROJ_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            Projections::Tests::getFailures()++; \
+        } \
+    } while (false)